@@ -4,7 +4,14 @@
 #include <gtkmm/label.h>
 #include <json/json.h>
 
+#include <cstdint>
+#include <optional>
+#include <set>
+#include <string_view>
+#include <unordered_map>
+
 #include "AModule.hpp"
+#include "util/format_template.hpp"
 
 namespace waybar {
 
@@ -13,7 +20,7 @@ class ALabel : public AModule {
   ALabel(const Json::Value &, const std::string &, const std::string &, const std::string &format,
          uint16_t interval = 0, bool ellipsize = false, bool enable_click = false,
          bool enable_scroll = false);
-  virtual ~ALabel() = default;
+  virtual ~ALabel();
   auto update() -> void override;
   virtual std::string getIcon(uint16_t, const std::string &alt = "", uint16_t max = 0);
   virtual std::string getIcon(uint16_t, const std::vector<std::string> &alts, uint16_t max = 0);
@@ -27,6 +34,33 @@ class ALabel : public AModule {
 
   bool handleToggle(GdkEventButton *const &e) override;
   virtual std::string getState(uint8_t value, bool lesser = false);
+  // Setters of label_ that skip the GTK call, and with it Pango shaping and a resize of the
+  // bar, if the value didn't change since it was last set through them. setMarkup() returns
+  // whether the markup changed.
+  bool setMarkup(const std::string &markup);
+  void setTooltipText(const std::string &text);
+  void setTooltipMarkup(const std::string &markup);
+  // Adds or removes a CSS class of label_ if it isn't in that state already
+  void setClass(const std::string &name, bool enabled);
+  bool hasClass(const std::string &name) const { return classes_.count(name) != 0; }
+
+  // Compiled `format`, compiled on first use and kept for the lifetime of the module
+  const util::FormatTemplate &getTemplate(const std::string &format);
+  // Whether the default format or one of the formats of the config references `name`
+  bool referenced(std::string_view name) const;
+
+ private:
+  void setTooltip(const std::string &tooltip, bool markup);
+
+  std::unordered_map<std::string, util::FormatTemplate> templates_;
+  // Last values set, nothing yet if std::nullopt
+  std::optional<std::string> markup_;
+  std::optional<std::string> tooltip_;
+  bool tooltip_markup_ = false;
+  std::set<std::string> classes_;
+  // Label and tooltip updates applied and skipped for being unchanged
+  uint64_t updates_applied_ = 0;
+  uint64_t updates_skipped_ = 0;
 };
 
 }  // namespace waybar
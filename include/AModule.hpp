@@ -1,11 +1,13 @@
 #pragma once
 
-#include <glibmm/dispatcher.h>
 #include <glibmm/markup.h>
 #include <gtkmm/eventbox.h>
 #include <json/json.h>
 
 #include "IModule.hpp"
+#include "util/event_queue.hpp"
+#include "util/SafeSignal.hpp"
+#include "util/reactor.hpp"
 
 namespace waybar {
 
@@ -17,7 +19,7 @@ class AModule : public IModule {
   operator Gtk::Widget &() override;
   auto doAction(const std::string &name) -> void override;
 
-  Glib::Dispatcher dp;
+  util::Dispatcher dp;
 
  protected:
   // Don't need to make an object directly
@@ -37,11 +39,24 @@ class AModule : public IModule {
   virtual bool handleToggle(GdkEventButton *const &ev);
   virtual bool handleScroll(GdkEventScroll *);
   virtual bool handleRelease(GdkEventButton *const &ev);
+  // Exit of the command of a user event, e.g. on-click, on the main thread
+  virtual void handleCommandExit(const std::string &event, int exit_code);
 
  private:
   bool handleUserEvent(GdkEventButton *const &ev);
+  void runOnUpdate();
+  // Runs the command of a user event, terminated along with the module if it is still running
+  void spawn(const std::string &event);
 
-  std::vector<int> pid_;
+  // Declared before the processes, whose callbacks emit it
+  SafeSignal<std::string, int> command_exited_;
+  bool on_update_running_ = false;
+  // an update came while on-update was running
+  bool on_update_pending_ = false;
+  util::Process on_update_;
+  std::vector<util::Process> children_;
+  uint64_t spawned_ = 0;
+  uint64_t coalesced_ = 0;
   gdouble distance_scrolled_y_;
   gdouble distance_scrolled_x_;
   std::map<std::string, std::string> eventActionMap_;
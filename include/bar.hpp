@@ -12,6 +12,7 @@
 #include <vector>
 
 #include "AModule.hpp"
+#include "util/update_batcher.hpp"
 #include "xdg-output-unstable-v1-client-protocol.h"
 
 namespace waybar {
@@ -128,6 +129,8 @@ class Bar {
   std::unique_ptr<BarIpcClient> _ipc_client;
 #endif
   std::vector<std::shared_ptr<waybar::AModule>> modules_all_;
+  // Destroyed before the modules whose updates it runs
+  util::UpdateBatcher updates_;
 };
 
 }  // namespace waybar
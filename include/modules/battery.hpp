@@ -16,6 +16,7 @@
 #include <vector>
 
 #include "ALabel.hpp"
+#include "util/scheduler.hpp"
 #include "util/sleeper_thread.hpp"
 
 namespace waybar::modules {
@@ -52,7 +53,7 @@ class Battery : public ALabel {
 
   util::SleeperThread thread_;
   util::SleeperThread thread_battery_update_;
-  util::SleeperThread thread_timer_;
+  util::Timer timer_;
 };
 
 }  // namespace waybar::modules
@@ -2,7 +2,7 @@
 
 #include "ALabel.hpp"
 #include "util/date.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -25,7 +25,7 @@ class Clock final : public ALabel {
   auto doAction(const std::string& name) -> void override;
 
  private:
-  util::SleeperThread thread_;
+  util::Timer timer_;
   std::locale locale_;
   std::vector<const date::time_zone*> time_zones_;
   int current_time_zone_idx_;
@@ -5,12 +5,16 @@
 #include <cstdint>
 #include <fstream>
 #include <numeric>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/history.hpp"
+#include "util/proc_file.hpp"
+#include "util/proc_stat.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
@@ -21,15 +25,48 @@ class Cpu : public ALabel {
   auto update() -> void override;
 
  private:
-  double getCpuLoad();
-  std::tuple<std::vector<uint16_t>, std::string> getCpuUsage();
-  std::tuple<float, float, float> getCpuFrequency();
-  std::vector<std::tuple<size_t, size_t>> parseCpuinfo();
-  std::vector<float> parseCpuFrequencies();
+  using CpuTimes = util::CpuTimes;
+
+  struct Sample {
+    CpuTimes times;
+    std::vector<float> frequencies;  // MHz
+  };
+
+  // Reads the kernel's cpu statistics for the sampler shared by all cpu modules
+  class Reader {
+   public:
+    // Frequencies are only read if asked for, they take a file per cpu
+    explicit Reader(bool frequencies) : frequencies_(frequencies) {}
+    void read(Sample& sample);
+
+   private:
+    // Fill their argument in place, reusing its storage
+    void parseCpuinfo(CpuTimes& times);
+    void parseCpuFrequencies(std::vector<float>& frequencies, size_t cpus);
 
-  std::vector<std::tuple<size_t, size_t>> prev_times_;
+    const bool frequencies_;
+#ifdef HAVE_CPU_LINUX
+    void discoverCpufreqFiles(size_t cpus);
+
+    util::ProcFile proc_stat_{"/proc/stat"};
+    util::ProcFile proc_cpuinfo_{"/proc/cpuinfo"};
+    // scaling_cur_freq of every cpu, rediscovered when cpus go on- or offline
+    std::vector<util::ProcFile> cpufreq_files_;
+    std::optional<size_t> cpufreq_cpus_;
+#endif
+  };
+
+  double getCpuLoad();
+  std::tuple<std::vector<uint16_t>, std::string> getCpuUsage(const CpuTimes& prev,
+                                                              const CpuTimes& curr);
+  std::tuple<float, float, float> getCpuFrequency(const std::vector<float>& frequencies);
 
-  util::SleeperThread thread_;
+  util::History usage_history_;
+  // usage and tooltip computed from the last sample
+  std::vector<uint16_t> usage_;
+  std::string usage_tooltip_;
+  util::Sampler<Sample>::Snapshot prev_sample_;
+  util::Sampler<Sample>::Subscription sampler_;
 };
 
 }  // namespace waybar::modules
@@ -2,13 +2,18 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
+#include <chrono>
 #include <csignal>
+#include <optional>
 #include <string>
+#include <vector>
 
 #include "ALabel.hpp"
 #include "util/command.hpp"
 #include "util/json.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/reactor.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -20,14 +25,17 @@ class Custom : public ALabel {
   void refresh(int /*signal*/) override;
 
  private:
-  void delayWorker();
-  void continuousWorker();
-  void waitingWorker();
+  void startExec();
+  void startStream();
+  // Records the key of the output of exec, returns whether exec has to run for it
+  bool checkKey(std::optional<std::string> key);
+  std::optional<std::string> fileKey() const;
   void parseOutputRaw();
   void parseOutputJson();
   void handleEvent();
   bool handleScroll(GdkEventScroll* e) override;
   bool handleToggle(GdkEventButton* const& e) override;
+  void handleCommandExit(const std::string& event, int exit_code) override;
 
   const std::string name_;
   std::string text_;
@@ -35,13 +43,28 @@ class Custom : public ALabel {
   std::string alt_;
   std::string tooltip_;
   std::vector<std::string> class_;
+  // classes of the output currently set on the label
+  std::vector<std::string> applied_class_;
   int percentage_;
-  FILE* fp_;
-  int pid_;
   util::command::res output_;
+  util::command::limits limits_;
+  // The result of exec-if is reused until it expires
+  std::chrono::steady_clock::duration exec_if_ttl_{};
+  std::chrono::steady_clock::time_point exec_if_expiry_;
+  int exec_if_result_ = 0;
+  // Key of the current output, exec only runs again once the key changes
+  std::optional<std::string> exec_key_;
+  bool key_unchanged_ = false;
   util::JsonParser parser_;
 
-  util::SleeperThread thread_;
+  util::Timer timer_;
+  util::Process process_;
+  // a process was started and didn't finish yet
+  std::atomic<bool> busy_ = false;
+  // the next run ignores the cached exec-if result and key
+  std::atomic<bool> forced_ = false;
+  // wakes the timer from the main thread, for runs forced while busy
+  util::Dispatcher rerun_;
 };
 
 }  // namespace waybar::modules
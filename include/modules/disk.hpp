@@ -4,10 +4,11 @@
 #include <sys/statvfs.h>
 
 #include <fstream>
+#include <optional>
 
 #include "ALabel.hpp"
 #include "util/format.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
@@ -18,9 +19,12 @@ class Disk : public ALabel {
   auto update() -> void override;
 
  private:
-  util::SleeperThread thread_;
+  // std::nullopt if statvfs() failed
+  using Stats = std::optional<struct statvfs>;
+
   std::string path_;
   std::string unit_;
+  util::Sampler<Stats>::Subscription sampler_;
 
   float calc_specific_divisor(const std::string divisor);
 };
@@ -1,12 +1,17 @@
 #pragma once
 
+#include <chrono>
+#include <condition_variable>
+#include <deque>
 #include <functional>
-#include <list>
 #include <memory>
 #include <mutex>
 #include <string>
+#include <string_view>
 #include <thread>
+#include <unordered_map>
 #include <utility>
+#include <vector>
 
 #include "util/json.hpp"
 
@@ -18,23 +23,52 @@ class EventHandler {
   virtual ~EventHandler() = default;
 };
 
+class State;
+
 class IPC {
  public:
-  IPC() { startIPC(); }
+  IPC();
+  ~IPC();
 
   void registerForIPC(const std::string&, EventHandler*);
   void unregisterForIPC(EventHandler*);
 
   std::string getSocket1Reply(const std::string& rq);
   Json::Value getSocket1JsonReply(const std::string& rq);
+  // Query several JSON requests in a single round-trip using Hyprland's [[BATCH]] syntax.
+  // Replies are returned in the order of the requests.
+  std::vector<Json::Value> getSocket1JsonReplies(const std::vector<std::string>& rqs);
+  // Send a request from the IPC worker thread. The callback, if any, is invoked on that thread.
+  void getSocket1ReplyAsync(const std::string& rq,
+                            std::function<void(const std::string&)> callback = {});
+
+  // Shared model of monitors, workspaces and clients, prefer it over querying socket1
+  State& state() { return *state_; }
 
  private:
+  static constexpr std::chrono::milliseconds kReconnectMin{100};
+  static constexpr std::chrono::milliseconds kReconnectMax{5000};
+
   void startIPC();
+  static int connectSocket2(const std::string& socketPath);
   void parseIPC(const std::string&);
+  void asyncWorker();
+  static std::vector<std::string_view> splitJsonDocuments(std::string_view data);
 
   std::mutex callbackMutex;
   util::JsonParser parser_;
-  std::list<std::pair<std::string, EventHandler*>> callbacks;
+  // handlers by event name, in registration order
+  std::unordered_map<std::string, std::vector<EventHandler*>> callbacks;
+
+  // path of the request socket, resolved once
+  std::string socket1Path_;
+  std::unique_ptr<State> state_;
+
+  std::mutex asyncMutex_;
+  std::condition_variable asyncCv_;
+  std::deque<std::pair<std::string, std::function<void(const std::string&)>>> asyncQueue_;
+  bool asyncRunning_ = true;
+  std::thread asyncThread_;
 };
 
 inline std::unique_ptr<IPC> gIPC;
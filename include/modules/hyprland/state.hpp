@@ -0,0 +1,70 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "modules/hyprland/backend.hpp"
+
+namespace waybar::modules::hyprland {
+
+/**
+ * Model of Hyprland's monitors, workspaces and clients shared by all modules and bars.
+ *
+ * The model is kept current by applying socket2 events to it. Events that don't carry enough
+ * information (e.g. `monitoradded`) mark the model stale, and the next reader refetches
+ * everything in one batched request, without holding the lock. Events that come in meanwhile are
+ * replayed on the fetched model, the deltas are idempotent. The snapshots have the same shape as
+ * the corresponding `hyprctl -j` replies.
+ */
+class State : public EventHandler {
+ public:
+  explicit State(IPC& ipc);
+  ~State() override;
+
+  void onEvent(const std::string& ev) override;
+
+  Json::Value monitors();
+  Json::Value workspaces();
+  Json::Value clients();
+  Json::Value activeWorkspace();
+
+  // Force a full refetch on the next read
+  void invalidate();
+
+ private:
+  static constexpr std::chrono::seconds kReconcileInterval{60};
+
+  void reconcileIfNeeded();
+  void apply(const std::string& eventName, const std::string& payload);
+  Json::Value* findWorkspace(const std::string& name);
+  Json::Value* findClient(const std::string& address);
+  Json::Value* focusedMonitor();
+  void setActiveWorkspace(Json::Value& monitor, const std::string& name);
+  void addWindows(int workspaceId, int count);
+
+  IPC& ipc_;
+  std::mutex mutex_;
+  bool stale_ = true;
+  // Properties of opened windows come from window rules, only the clients are refetched
+  bool clientsStale_ = false;
+  bool fetching_ = false;
+  std::condition_variable fetched_;
+  // events received while fetching, as {name, payload}
+  std::vector<std::pair<std::string, std::string>> pending_;
+  std::chrono::steady_clock::time_point lastReconcile_;
+  // title from the last `activewindow` event, applied on the following `activewindowv2`
+  std::string activeTitle_;
+
+  std::map<std::string, Json::Value> monitors_;  // by name
+  std::map<int, Json::Value> workspaces_;        // by id
+  std::map<std::string, Json::Value> clients_;   // by address, 0x prefixed
+};
+
+}  // namespace waybar::modules::hyprland
@@ -8,6 +8,7 @@
 #include "bar.hpp"
 #include "modules/hyprland/backend.hpp"
 #include "util/json.hpp"
+#include "util/rewrite_string.hpp"
 
 namespace waybar::modules::hyprland {
 
@@ -41,8 +42,8 @@ class Window : public waybar::AAppIconLabel, public EventHandler {
     static auto parse(const Json::Value&) -> WindowData;
   };
 
-  auto getActiveWorkspace(const std::string&) -> Workspace;
-  auto getActiveWorkspace() -> Workspace;
+  auto getActiveWorkspace(const std::string&, const Json::Value& monitors,
+                          const Json::Value& workspaces) -> Workspace;
   void onEvent(const std::string&) override;
   void queryActiveWorkspace();
   void setClass(const std::string&, bool enable);
@@ -53,6 +54,7 @@ class Window : public waybar::AAppIconLabel, public EventHandler {
   util::JsonParser parser_;
   WindowData window_data_;
   Workspace workspace_;
+  util::RewriteRules rewrite_;
   std::string solo_class_;
   std::string last_solo_class_;
   bool solo_;
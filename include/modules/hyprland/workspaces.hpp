@@ -16,6 +16,7 @@
 #include "bar.hpp"
 #include "modules/hyprland/backend.hpp"
 #include "util/enum.hpp"
+#include "util/rewrite_string.hpp"
 
 using WindowAddress = std::string;
 namespace waybar::modules::hyprland {
@@ -98,6 +99,8 @@ class Workspaces : public AModule, public EventHandler {
  private:
   void onEvent(const std::string&) override;
   void update_window_count();
+  void update_window_count(const Json::Value& workspaces_json);
+  void update_visible_workspaces(const Json::Value& monitors);
   void initialize_window_maps();
   void sort_workspaces();
   void create_workspace(Json::Value& workspace_data,
@@ -130,13 +133,13 @@ class Workspaces : public AModule, public EventHandler {
 
   std::string format_;
   std::map<std::string, std::string> icons_map_;
-  Json::Value window_rewrite_rules_;
-  std::map<std::string, std::string> regex_cache_;
+  util::RewriteRules window_rewrite_rules_;
   std::string format_window_separator_;
   std::string window_rewrite_default_;
   bool with_icon_;
   uint64_t monitor_id_;
   std::string active_workspace_name_;
+  std::vector<std::string> visible_workspaces_;
   std::vector<std::unique_ptr<Workspace>> workspaces_;
   std::vector<Json::Value> workspaces_to_create_;
   std::vector<std::string> workspaces_to_remove_;
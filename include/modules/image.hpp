@@ -10,7 +10,7 @@
 #include "gtkmm/box.h"
 #include "util/command.hpp"
 #include "util/json.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 
@@ -33,8 +33,9 @@ class Image : public AModule {
   int size_;
   int interval_;
   util::command::res output_;
+  util::command::limits limits_;
 
-  util::SleeperThread thread_;
+  util::Timer timer_;
 };
 
 }  // namespace waybar::modules
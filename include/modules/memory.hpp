@@ -2,11 +2,14 @@
 
 #include <fmt/format.h>
 
-#include <fstream>
-#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <bitset>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/history.hpp"
+#include "util/proc_file.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
@@ -16,12 +19,52 @@ class Memory : public ALabel {
   virtual ~Memory() = default;
   auto update() -> void override;
 
+  // Values in kB of the /proc/meminfo fields used by the module
+  struct Meminfo {
+    enum Key {
+      MemTotal,
+      MemFree,
+      MemAvailable,
+      Buffers,
+      Cached,
+      SReclaimable,
+      Shmem,
+      SwapTotal,
+      SwapFree,
+      ZfsSize,  // size of the ZFS ARC, not part of /proc/meminfo
+      kKeys
+    };
+
+    unsigned long operator[](Key key) const { return values[key]; }
+    bool has(Key key) const { return present[key]; }
+    void set(Key key, unsigned long value) {
+      values[key] = value;
+      present.set(key);
+    }
+
+    std::array<unsigned long, kKeys> values{};
+    std::bitset<kKeys> present;
+  };
+
  private:
-  void parseMeminfo();
+  // Reads the kernel's memory statistics for the sampler shared by all memory modules
+  class Reader {
+   public:
+    // Fills meminfo in place
+    void parseMeminfo(Meminfo& meminfo);
 
-  std::unordered_map<std::string, unsigned long> meminfo_;
+#ifdef HAVE_MEMORY_LINUX
+   private:
+    util::ProcFile proc_meminfo_{"/proc/meminfo"};
+    util::ProcFile zfs_arcstats_{"/proc/spl/kstat/zfs/arcstats"};
+    bool has_zfs_ = true;
+#endif
+  };
 
-  util::SleeperThread thread_;
+  util::History percentage_history_;
+  // set by the sampler, updates on clicks don't bring a new sample
+  std::atomic<bool> new_sample_ = false;
+  util::Sampler<Meminfo>::Subscription sampler_;
 };
 
 }  // namespace waybar::modules
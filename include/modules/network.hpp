@@ -8,9 +8,13 @@
 #include <netlink/netlink.h>
 #include <sys/epoll.h>
 
+#include <chrono>
+#include <cstdint>
 #include <optional>
 
 #include "ALabel.hpp"
+#include "util/history.hpp"
+#include "util/sampler.hpp"
 #include "util/sleeper_thread.hpp"
 #ifdef WANT_RFKILL
 #include "util/rfkill.hpp"
@@ -24,6 +28,13 @@ class Network : public ALabel {
   virtual ~Network();
   auto update() -> void override;
 
+  // Byte counters of one interface, or summed over all of them
+  struct BandwidthCounters {
+    std::chrono::steady_clock::time_point time;
+    uint64_t down = 0;
+    uint64_t up = 0;
+  };
+
  private:
   static const uint8_t MAX_RETRY = 5;
   static const uint8_t EPOLL_MAX = 200;
@@ -46,7 +57,9 @@ class Network : public ALabel {
   const std::string getNetworkState() const;
   void clearIface();
   bool wildcardMatch(const std::string& pattern, const std::string& text) const;
-  std::optional<std::pair<unsigned long long, unsigned long long>> readBandwidthUsage();
+  void subscribeBandwidth(const std::string& key,
+                          const std::function<util::Sampler<BandwidthCounters>::Reader()>&);
+  void updateBandwidth();
 
   int ifid_;
   sa_family_t family_;
@@ -64,8 +77,18 @@ class Network : public ALabel {
   bool dump_in_progress_;
   bool is_p2p_;
 
-  unsigned long long bandwidth_down_total_;
-  unsigned long long bandwidth_up_total_;
+  std::chrono::milliseconds bandwidth_interval_;
+  bool bandwidth_aggregate_;
+  // interface bandwidth_sampler_ reads, unused in aggregate mode
+  std::string bandwidth_ifname_;
+  util::Sampler<BandwidthCounters>::Subscription bandwidth_sampler_;
+  // counters of the previous update, std::nullopt if there is no sampler
+  std::optional<BandwidthCounters> bandwidth_prev_;
+  // bytes per second
+  double bandwidth_down_;
+  double bandwidth_up_;
+  util::History bandwidth_down_history_;
+  util::History bandwidth_up_history_;
 
   std::string state_;
   std::string essid_;
@@ -30,7 +30,7 @@ class BarIpcClient {
 
  private:
   void onInitialConfig(const struct Ipc::ipc_response& res);
-  void onIpcEvent(const struct Ipc::ipc_response&);
+  void onIpcEvent(uint32_t type, const Json::Value& payload);
   void onCmd(const struct Ipc::ipc_response&);
   void onConfigUpdate(const swaybar_config& config);
   void onVisibilityUpdate(bool visible_by_modifier);
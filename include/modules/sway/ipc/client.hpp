@@ -1,21 +1,26 @@
 #pragma once
 
+#include <json/value.h>
 #include <sigc++/sigc++.h>
-#include <sys/socket.h>
-#include <sys/un.h>
-#include <unistd.h>
 
-#include <cstring>
+#include <cstdint>
 #include <memory>
-#include <mutex>
-#include <stdexcept>
 #include <string>
 
 #include "ipc.hpp"
-#include "util/sleeper_thread.hpp"
 
 namespace waybar::modules::sway {
 
+class IpcHub;
+
+/**
+ * Sway IPC client of a module.
+ *
+ * All clients of the process share one connection to sway (see IpcHub in client.cpp): commands
+ * are serialized over a single socket, and events are read from a single socket subscribed to
+ * the union of the event types of all clients. Each event is parsed once and emitted to every
+ * client subscribed to its type, from the reader thread.
+ */
 class Ipc {
  public:
   Ipc();
@@ -27,27 +32,15 @@ class Ipc {
     std::string payload;
   };
 
-  sigc::signal<void, const struct ipc_response &> signal_event;
+  sigc::signal<void, uint32_t, const Json::Value &> signal_event;
   sigc::signal<void, const struct ipc_response &> signal_cmd;
 
   void sendCmd(uint32_t type, const std::string &payload = "");
+  // payload is a JSON array of event names, as for IPC_SUBSCRIBE
   void subscribe(const std::string &payload);
-  void handleEvent();
-  void setWorker(std::function<void()> &&func);
-
- protected:
-  static inline const std::string ipc_magic_ = "i3-ipc";
-  static inline const size_t ipc_header_size_ = ipc_magic_.size() + 8;
-
-  const std::string getSocketPath() const;
-  int open(const std::string &) const;
-  struct ipc_response send(int fd, uint32_t type, const std::string &payload = "");
-  struct ipc_response recv(int fd);
-
-  int fd_;
-  int fd_event_;
-  std::mutex mutex_;
-  util::SleeperThread thread_;
+
+ private:
+  std::shared_ptr<IpcHub> hub_;
 };
 
 }  // namespace waybar::modules::sway
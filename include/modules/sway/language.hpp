@@ -44,7 +44,7 @@ class Language : public ALabel, public sigc::trackable {
     std::map<std::string, rxkb_layout*> base_layouts_by_name_;
   };
 
-  void onEvent(const struct Ipc::ipc_response&);
+  void onEvent(uint32_t type, const Json::Value& payload);
   void onCmd(const struct Ipc::ipc_response&);
 
   auto set_current_layout(std::string current_layout) -> void;
@@ -17,10 +17,9 @@ class Mode : public ALabel, public sigc::trackable {
   auto update() -> void override;
 
  private:
-  void onEvent(const struct Ipc::ipc_response&);
+  void onEvent(uint32_t type, const Json::Value& payload);
 
   std::string mode_;
-  util::JsonParser parser_;
   std::mutex mutex_;
   Ipc ipc_;
 };
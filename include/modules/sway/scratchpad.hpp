@@ -21,7 +21,7 @@ class Scratchpad : public ALabel {
  private:
   auto getTree() -> void;
   auto onCmd(const struct Ipc::ipc_response&) -> void;
-  auto onEvent(const struct Ipc::ipc_response&) -> void;
+  auto onEvent(uint32_t type, const Json::Value& payload) -> void;
 
   std::string tooltip_format_;
   bool show_empty_;
@@ -30,6 +30,5 @@ class Scratchpad : public ALabel {
   int count_;
   std::mutex mutex_;
   Ipc ipc_;
-  util::JsonParser parser_;
 };
 }  // namespace waybar::modules::sway
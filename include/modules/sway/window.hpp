@@ -9,6 +9,7 @@
 #include "client.hpp"
 #include "modules/sway/ipc/client.hpp"
 #include "util/json.hpp"
+#include "util/rewrite_string.hpp"
 
 namespace waybar::modules::sway {
 
@@ -20,7 +21,7 @@ class Window : public AAppIconLabel, public sigc::trackable {
 
  private:
   void setClass(std::string classname, bool enable);
-  void onEvent(const struct Ipc::ipc_response&);
+  void onEvent(uint32_t type, const Json::Value& payload);
   void onCmd(const struct Ipc::ipc_response&);
   std::tuple<std::size_t, int, int, std::string, std::string, std::string, std::string, std::string>
   getFocusedNode(const Json::Value& nodes, std::string& output);
@@ -36,7 +37,7 @@ class Window : public AAppIconLabel, public sigc::trackable {
   std::size_t app_nb_;
   std::string shell_;
   int floating_count_;
-  util::JsonParser parser_;
+  util::RewriteRules rewrite_;
   std::mutex mutex_;
   Ipc ipc_;
 };
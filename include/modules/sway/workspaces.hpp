@@ -29,7 +29,9 @@ class Workspaces : public AModule, public sigc::trackable {
   static int convertWorkspaceNameToNum(std::string name);
 
   void onCmd(const struct Ipc::ipc_response&);
-  void onEvent(const struct Ipc::ipc_response&);
+  void onEvent(uint32_t type, const Json::Value& payload);
+  bool applyEvent(const Json::Value& event);
+  void rebuildWorkspaces();
   bool filterButtons();
   Gtk::Button& addButton(const Json::Value&);
   void onButtonReady(const Json::Value&, Gtk::Button&);
@@ -40,6 +42,9 @@ class Workspaces : public AModule, public sigc::trackable {
   bool handleScroll(GdkEventScroll*) override;
 
   const Bar& bar_;
+  // workspaces as reported by sway, kept current from workspace events
+  std::vector<Json::Value> sway_workspaces_;
+  // sway workspaces of this bar and persistent workspaces, in display order
   std::vector<Json::Value> workspaces_;
   std::vector<std::string> high_priority_named_;
   std::vector<std::string> workspaces_order_;
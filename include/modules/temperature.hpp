@@ -2,10 +2,12 @@
 
 #include <fmt/format.h>
 
+#include <atomic>
 #include <fstream>
 
 #include "ALabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/history.hpp"
+#include "util/sampler.hpp"
 
 namespace waybar::modules {
 
@@ -16,11 +18,15 @@ class Temperature : public ALabel {
   auto update() -> void override;
 
  private:
-  float getTemperature();
+  // Returns a reader of the temperature in °C for the shared sampler
+  util::Sampler<float>::Reader makeReader();
   bool isCritical(uint16_t);
 
   std::string file_path_;
-  util::SleeperThread thread_;
+  util::History history_;
+  // set by the sampler, updates on clicks don't bring a new sample
+  std::atomic<bool> new_sample_ = false;
+  util::Sampler<float>::Subscription sampler_;
 };
 
 }  // namespace waybar::modules
@@ -5,7 +5,7 @@
 #include <glibmm/refptr.h>
 
 #include "AIconLabel.hpp"
-#include "util/sleeper_thread.hpp"
+#include "util/scheduler.hpp"
 
 namespace waybar::modules {
 class User : public AIconLabel {
@@ -17,7 +17,7 @@ class User : public AIconLabel {
   bool handleToggle(GdkEventButton* const& e) override;
 
  private:
-  util::SleeperThread thread_;
+  util::Timer timer_;
 
   static constexpr inline int defaultUserImageWidth_ = 20;
   static constexpr inline int defaultUserImageHeight_ = 20;
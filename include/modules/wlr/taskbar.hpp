@@ -20,6 +20,7 @@
 #include "client.hpp"
 #include "giomm/desktopappinfo.h"
 #include "util/json.hpp"
+#include "util/rewrite_string.hpp"
 #include "wlr-foreign-toplevel-management-unstable-v1-client-protocol.h"
 
 namespace waybar::modules::wlr {
@@ -149,6 +150,7 @@ class Taskbar : public waybar::AModule {
   std::vector<Glib::RefPtr<Gtk::IconTheme>> icon_themes_;
   std::unordered_set<std::string> ignore_list_;
   std::map<std::string, std::string> app_ids_replace_map_;
+  util::RewriteRules rewrite_rules_;
 
   struct zwlr_foreign_toplevel_manager_v1 *manager_;
   struct wl_seat *seat_;
@@ -174,6 +176,7 @@ class Taskbar : public waybar::AModule {
   const std::vector<Glib::RefPtr<Gtk::IconTheme>> &icon_themes() const;
   const std::unordered_set<std::string> &ignore_list() const;
   const std::map<std::string, std::string> &app_ids_replace_map() const;
+  const util::RewriteRules &rewrite_rules() const;
 };
 
 } /* namespace waybar::modules::wlr */
@@ -1,26 +1,32 @@
 #pragma once
 
-#include <glibmm/dispatcher.h>
 #include <sigc++/signal.h>
 
+#include <atomic>
 #include <functional>
-#include <mutex>
-#include <queue>
+#include <memory>
 #include <thread>
 #include <tuple>
 #include <type_traits>
 #include <utility>
 
+#include "util/event_queue.hpp"
+
 namespace waybar {
 
 /**
  * Thread-safe signal wrapper.
- * Uses Glib::Dispatcher to pass events to another thread and locked queue to pass the arguments.
+ * Events emitted from other threads are moved into the shared util::EventQueue, with their
+ * arguments, and delivered on the main thread. Pending events are dropped when the signal is
+ * destroyed.
  */
 template <typename... Args>
 struct SafeSignal : sigc::signal<void(std::decay_t<Args>...)> {
  public:
-  SafeSignal() { dp_.connect(sigc::mem_fun(*this, &SafeSignal::handle_event)); }
+  SafeSignal() = default;
+  SafeSignal(const SafeSignal&) = delete;
+  SafeSignal& operator=(const SafeSignal&) = delete;
+  ~SafeSignal() { alive_->store(false, std::memory_order_release); }
 
   template <typename... EmitArgs>
   void emit(EmitArgs&&... args) {
@@ -34,11 +40,8 @@ struct SafeSignal : sigc::signal<void(std::decay_t<Args>...)> {
        */
       signal_t::emit(std::forward<EmitArgs>(args)...);
     } else {
-      {
-        std::unique_lock lock(mutex_);
-        queue_.emplace(std::forward<EmitArgs>(args)...);
-      }
-      dp_.emit();
+      util::EventQueue::inst().post(
+          std::make_unique<Event>(*this, std::forward<EmitArgs>(args)...));
     }
   }
 
@@ -55,18 +58,27 @@ struct SafeSignal : sigc::signal<void(std::decay_t<Args>...)> {
   using signal_t::emit_reverse;
   using signal_t::make_slot;
 
-  void handle_event() {
-    for (std::unique_lock lock(mutex_); !queue_.empty(); lock.lock()) {
-      auto args = queue_.front();
-      queue_.pop();
-      lock.unlock();
-      std::apply(cached_fn_, args);
+  // The arguments are constructed in place from the ones of emit(), and passed to the slots by
+  // reference from there
+  class Event : public util::EventQueue::Event {
+   public:
+    template <typename... EmitArgs>
+    explicit Event(SafeSignal& signal, EmitArgs&&... args)
+        : signal_(signal), alive_(signal.alive_), args_(std::forward<EmitArgs>(args)...) {}
+
+    void run() override {
+      if (alive_->load(std::memory_order_acquire)) {
+        std::apply(signal_.cached_fn_, args_);
+      }
     }
-  }
 
-  Glib::Dispatcher dp_;
-  std::mutex mutex_;
-  std::queue<arg_tuple_t> queue_;
+   private:
+    SafeSignal& signal_;
+    std::shared_ptr<std::atomic<bool>> alive_;
+    arg_tuple_t args_;
+  };
+
+  std::shared_ptr<std::atomic<bool>> alive_ = std::make_shared<std::atomic<bool>>(true);
   const std::thread::id main_tid_ = std::this_thread::get_id();
   // cache functor for signal emission to avoid recreating it on each event
   const slot_t cached_fn_ = make_slot();
@@ -2,6 +2,8 @@
 
 #include <fcntl.h>
 #include <giomm.h>
+#include <poll.h>
+#include <spawn.h>
 #include <spdlog/spdlog.h>
 #include <sys/wait.h>
 #include <unistd.h>
@@ -13,10 +15,13 @@
 #include <sys/procctl.h>
 #endif
 
-#include <array>
+#include <algorithm>
+#include <chrono>
+#include <string_view>
+#include <thread>
+#include <vector>
 
-extern std::mutex reap_mtx;
-extern std::list<pid_t> reap;
+extern char** environ;
 
 namespace waybar::util::command {
 
@@ -25,20 +30,211 @@ struct res {
   std::string out;
 };
 
-inline std::string read(FILE* fp) {
-  std::array<char, 128> buffer = {0};
-  std::string output;
-  while (feof(fp) == 0) {
-    if (fgets(buffer.data(), 128, fp) != nullptr) {
-      output += buffer.data();
+struct limits {
+  // The command is terminated when it runs longer, zero for no timeout
+  std::chrono::milliseconds timeout{0};
+  // Output beyond this is not read, and the command is terminated
+  size_t max_output = 1 << 20;
+};
+
+// Time a terminated command gets to exit on SIGTERM, before it is sent SIGKILL
+constexpr std::chrono::milliseconds kill_grace{2000};
+
+// Characters that only a shell interprets; commands without them are run directly
+inline bool needsShell(std::string_view cmd) {
+  return cmd.find_first_of("|&;<>()$`\\\"'*?[]#~=%{}!\n") != std::string_view::npos;
+}
+
+/**
+ * Starts `cmd` with posix_spawn, in its own process group and with all signals unblocked,
+ * `out_fd` as its stdout unless it is -1. Commands without shell syntax are run without
+ * /bin/sh, which is still used if the first word isn't an executable, e.g. a shell builtin.
+ * Returns -1 on failure.
+ */
+inline pid_t spawn(const std::string& cmd, int out_fd) {
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (out_fd != -1) {
+    posix_spawn_file_actions_adddup2(&actions, out_fd, STDOUT_FILENO);
+  }
+  posix_spawnattr_t attr;
+  posix_spawnattr_init(&attr);
+  sigset_t mask;
+  sigemptyset(&mask);
+  posix_spawnattr_setsigmask(&attr, &mask);
+  posix_spawnattr_setpgroup(&attr, 0);
+  posix_spawnattr_setflags(&attr, POSIX_SPAWN_SETSIGMASK | POSIX_SPAWN_SETPGROUP);
+
+  pid_t pid = -1;
+  int err = ENOENT;
+  if (!needsShell(cmd)) {
+    std::vector<std::string> words;
+    for (size_t pos = cmd.find_first_not_of(" \t"); pos != std::string::npos;) {
+      const auto end = cmd.find_first_of(" \t", pos);
+      words.push_back(cmd.substr(pos, end - pos));
+      pos = cmd.find_first_not_of(" \t", end);
+    }
+    if (!words.empty()) {
+      std::vector<char*> argv;
+      for (auto& word : words) {
+        argv.push_back(word.data());
+      }
+      argv.push_back(nullptr);
+      err = posix_spawnp(&pid, argv[0], &actions, &attr, argv.data(), environ);
+    }
+  }
+  if (err == ENOENT) {
+    const char* argv[] = {"sh", "-c", cmd.c_str(), nullptr};
+    err = posix_spawn(&pid, "/bin/sh", &actions, &attr, const_cast<char* const*>(argv), environ);
+  }
+  posix_spawnattr_destroy(&attr);
+  posix_spawn_file_actions_destroy(&actions);
+  if (err != 0) {
+    spdlog::error("Unable to exec cmd {}, error {}", cmd, strerror(err));
+    return -1;
+  }
+  return pid;
+}
+
+/**
+ * Like spawn(), but with fork and always through /bin/sh, to have the command terminated when
+ * the bar exits, even if it crashes. posix_spawn can't ask for a signal on the death of the
+ * parent. Only for endless scripts: the child must not log or allocate, other threads may hold
+ * locks that it inherits.
+ */
+inline pid_t forkSpawn(const std::string& cmd, int out_fd) {
+  pid_t child_pid = fork();
+
+  if (child_pid < 0) {
+    spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
+    return -1;
+  }
+
+  if (!child_pid) {
+    sigset_t mask;
+    sigfillset(&mask);
+    // Reset sigmask
+    pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
+    // Kill child if Waybar exits
+    int deathsig = SIGTERM;
+#ifdef __linux__
+    prctl(PR_SET_PDEATHSIG, deathsig);
+#endif
+#ifdef __FreeBSD__
+    procctl(P_PID, 0, PROC_PDEATHSIG_CTL, reinterpret_cast<void*>(&deathsig));
+#endif
+    if (out_fd != -1) {
+      dup2(out_fd, 1);
+    }
+    setpgid(0, 0);
+    execlp("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
+    _exit(127);
+  }
+  // Also here, so that the group exists once this returns
+  setpgid(child_pid, child_pid);
+  return child_pid;
+}
+
+// Exit code of a waited for status, 128 + the signal for commands killed by one, as in sh
+inline int exitCode(int stat) {
+  if (WIFSIGNALED(stat)) {
+    spdlog::debug("Cmd killed by {}", WTERMSIG(stat));
+    return 128 + WTERMSIG(stat);
+  }
+  return WEXITSTATUS(stat);
+}
+
+// Runs `cmd` to completion, collecting its output into `out` unless it is null
+inline int run(const std::string& cmd, const limits& limits, std::string* out) {
+  if (cmd.empty()) return -1;
+  int fd[2];
+  // The read end must not leak into children spawned by other threads meanwhile, see open()
+  if (pipe2(fd, O_CLOEXEC) != 0) {
+    spdlog::error("Unable to pipe fd");
+    return -1;
+  }
+  const pid_t pid = spawn(cmd, fd[1]);
+  ::close(fd[1]);
+  if (pid == -1) {
+    ::close(fd[0]);
+    return -1;
+  }
+
+  // Large reads into a per-thread buffer that is kept across commands
+  constexpr size_t chunk = 64 * 1024;
+  thread_local std::string buffer;
+  size_t length = 0;
+  const auto deadline = std::chrono::steady_clock::now() + limits.timeout;
+  bool stop = false;
+  for (;;) {
+    int wait_ms = -1;
+    if (limits.timeout.count() > 0) {
+      const auto left = std::chrono::ceil<std::chrono::milliseconds>(
+          deadline - std::chrono::steady_clock::now());
+      if (left.count() <= 0) {
+        spdlog::warn("Cmd {} timed out after {}ms", cmd, limits.timeout.count());
+        stop = true;
+        break;
+      }
+      wait_ms = left.count();
+    }
+    pollfd pfd = {fd[0], POLLIN, 0};
+    const int ready = poll(&pfd, 1, wait_ms);
+    if (ready == 0 || (ready == -1 && errno == EINTR)) continue;
+    if (ready == -1) break;
+
+    size_t want = chunk;
+    if (out != nullptr) {
+      if (length >= limits.max_output) {
+        spdlog::warn("Cmd {} wrote more than {} bytes", cmd, limits.max_output);
+        stop = true;
+        break;
+      }
+      want = std::min(chunk, limits.max_output - length);
+    } else {
+      length = 0;
+    }
+    if (buffer.size() < length + want) {
+      buffer.resize(length + want);
     }
+    const auto n = ::read(fd[0], buffer.data() + length, want);
+    if (n == 0) break;
+    if (n == -1) {
+      if (errno == EINTR || errno == EAGAIN) continue;
+      break;
+    }
+    length += n;
   }
+  ::close(fd[0]);
 
-  // Remove last newline
-  if (!output.empty() && output[output.length() - 1] == '\n') {
-    output.erase(output.length() - 1);
+  int stat = 0;
+  pid_t ret = 0;
+  if (stop) {
+    killpg(pid, SIGTERM);
+    const auto kill_deadline = std::chrono::steady_clock::now() + kill_grace;
+    while ((ret = waitpid(pid, &stat, WNOHANG)) == 0 &&
+           std::chrono::steady_clock::now() < kill_deadline) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    if (ret == 0) {
+      spdlog::warn("Cmd {} ignored SIGTERM, killing it", cmd);
+      killpg(pid, SIGKILL);
+    }
+  }
+  while (ret != pid && (ret = waitpid(pid, &stat, 0)) == -1) {
+    if (errno != EINTR) {
+      spdlog::debug("waitpid failed: {}", strerror(errno));
+      return -1;
+    }
+  }
+  if (out != nullptr) {
+    // Remove last newline
+    if (length > 0 && buffer[length - 1] == '\n') {
+      --length;
+    }
+    out->assign(buffer, 0, length);
   }
-  return output;
+  return command::exitCode(stat);
 }
 
 inline int close(FILE* fp, pid_t pid) {
@@ -66,8 +262,9 @@ inline int close(FILE* fp, pid_t pid) {
   return stat;
 }
 
-inline FILE* open(const std::string& cmd, int& pid) {
-  if (cmd == "") return nullptr;
+// Like open(), returning the read end of the pipe itself
+inline int openFd(const std::string& cmd, int& pid) {
+  if (cmd == "") return -1;
   int fd[2];
   // Open the pipe with the close-on-exec flag set, so it will not be inherited
   // by any other subprocesses launched by other threads (which could result in
@@ -75,95 +272,32 @@ inline FILE* open(const std::string& cmd, int& pid) {
   // to read from it)
   if (pipe2(fd, O_CLOEXEC) != 0) {
     spdlog::error("Unable to pipe fd");
-    return nullptr;
-  }
-
-  pid_t child_pid = fork();
-
-  if (child_pid < 0) {
-    spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
-    ::close(fd[0]);
-    ::close(fd[1]);
-    return nullptr;
+    return -1;
   }
 
-  if (!child_pid) {
-    int err;
-    sigset_t mask;
-    sigfillset(&mask);
-    // Reset sigmask
-    err = pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
-    if (err != 0) spdlog::error("pthread_sigmask in open failed: {}", strerror(err));
-    // Kill child if Waybar exits
-    int deathsig = SIGTERM;
-#ifdef __linux__
-    if (prctl(PR_SET_PDEATHSIG, deathsig) != 0) {
-      spdlog::error("prctl(PR_SET_PDEATHSIG) in open failed: {}", strerror(errno));
-    }
-#endif
-#ifdef __FreeBSD__
-    if (procctl(P_PID, 0, PROC_PDEATHSIG_CTL, reinterpret_cast<void*>(&deathsig)) == -1) {
-      spdlog::error("procctl(PROC_PDEATHSIG_CTL) in open failed: {}", strerror(errno));
-    }
-#endif
+  const pid_t child_pid = forkSpawn(cmd, fd[1]);
+  ::close(fd[1]);
+  if (child_pid == -1) {
     ::close(fd[0]);
-    dup2(fd[1], 1);
-    setpgid(child_pid, child_pid);
-    execlp("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
-    exit(0);
-  } else {
-    ::close(fd[1]);
+    return -1;
   }
   pid = child_pid;
-  return fdopen(fd[0], "r");
+  return fd[0];
 }
 
-inline struct res exec(const std::string& cmd) {
-  int pid;
-  auto fp = command::open(cmd, pid);
-  if (!fp) return {-1, ""};
-  auto output = command::read(fp);
-  auto stat = command::close(fp, pid);
-  return {WEXITSTATUS(stat), output};
+inline FILE* open(const std::string& cmd, int& pid) {
+  auto fd = command::openFd(cmd, pid);
+  return fd == -1 ? nullptr : fdopen(fd, "r");
 }
 
-inline struct res execNoRead(const std::string& cmd) {
-  int pid;
-  auto fp = command::open(cmd, pid);
-  if (!fp) return {-1, ""};
-  auto stat = command::close(fp, pid);
-  return {WEXITSTATUS(stat), ""};
+inline struct res exec(const std::string& cmd, const limits& limits = {}) {
+  std::string output;
+  auto exit_code = command::run(cmd, limits, &output);
+  return {exit_code, output};
 }
 
-inline int32_t forkExec(const std::string& cmd) {
-  if (cmd == "") return -1;
-
-  pid_t pid = fork();
-
-  if (pid < 0) {
-    spdlog::error("Unable to exec cmd {}, error {}", cmd.c_str(), strerror(errno));
-    return pid;
-  }
-
-  // Child executes the command
-  if (!pid) {
-    int err;
-    sigset_t mask;
-    sigfillset(&mask);
-    // Reset sigmask
-    err = pthread_sigmask(SIG_UNBLOCK, &mask, nullptr);
-    if (err != 0) spdlog::error("pthread_sigmask in forkExec failed: {}", strerror(err));
-    setpgid(pid, pid);
-    execl("/bin/sh", "sh", "-c", cmd.c_str(), (char*)0);
-    exit(0);
-  } else {
-    reap_mtx.lock();
-    reap.push_back(pid);
-    reap_mtx.unlock();
-    spdlog::debug("Added child to reap list: {}", pid);
-  }
-
-  return pid;
+inline struct res execNoRead(const std::string& cmd, const limits& limits = {}) {
+  return {command::run(cmd, limits, nullptr), ""};
 }
 
 }  // namespace waybar::util::command
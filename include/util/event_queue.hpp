@@ -0,0 +1,107 @@
+#pragma once
+
+#include <glibmm/main.h>
+#include <sigc++/signal.h>
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace waybar::util {
+
+/**
+ * Passes events from any thread to the main loop.
+ *
+ * One process-wide lock-free multi-producer queue, drained on the main thread by a single
+ * GSource watching an eventfd. Producers only write the eventfd when the queue goes from idle to
+ * pending, so a burst of events wakes the main loop once. Events are allocated by the producer
+ * and handed over without copying their payload.
+ */
+class EventQueue {
+ public:
+  class Event {
+   public:
+    virtual ~Event() = default;
+    // Runs on the main thread
+    virtual void run() = 0;
+
+   private:
+    friend class EventQueue;
+    std::atomic<Event*> next_ = nullptr;
+  };
+
+  static EventQueue& inst();
+
+  EventQueue(const EventQueue&) = delete;
+  EventQueue& operator=(const EventQueue&) = delete;
+  ~EventQueue();
+
+  void post(std::unique_ptr<Event> event);
+
+  template <typename Fn, typename = std::enable_if_t<std::is_invocable_v<Fn&>>>
+  void post(Fn&& fn) {
+    post(std::make_unique<FnEvent<std::decay_t<Fn>>>(std::forward<Fn>(fn)));
+  }
+
+ private:
+  template <typename Fn>
+  class FnEvent : public Event {
+   public:
+    explicit FnEvent(Fn fn) : fn_(std::move(fn)) {}
+    void run() override { fn_(); }
+
+   private:
+    Fn fn_;
+  };
+
+  // A stub event keeps the list non-empty, it never runs
+  class Stub : public Event {
+    void run() override {}
+  };
+
+  EventQueue();
+
+  void push(Event* event);
+  // nullptr if the queue is empty; spins while a producer is halfway through a push
+  Event* pop();
+  bool dispatch(Glib::IOCondition);
+  void wake();
+
+  // Producers append at head_, the main thread takes events from tail_
+  std::atomic<Event*> head_;
+  Event* tail_;
+  Stub stub_;
+  std::atomic<bool> signaled_ = false;
+  int fd_;
+  sigc::connection source_;
+};
+
+/**
+ * Drop-in for Glib::Dispatcher on top of the EventQueue.
+ *
+ * emit() may be called from any thread; connected slots run on the main thread. Emissions that
+ * arrive while one is still pending are merged into it. Pending emissions are dropped when the
+ * dispatcher is destroyed.
+ */
+class Dispatcher {
+ public:
+  Dispatcher();
+  Dispatcher(const Dispatcher&) = delete;
+  Dispatcher& operator=(const Dispatcher&) = delete;
+  ~Dispatcher();
+
+  sigc::connection connect(const sigc::slot<void()>& slot) { return state_->signal.connect(slot); }
+  void emit();
+
+ private:
+  struct State {
+    sigc::signal<void()> signal;
+    std::atomic<bool> pending = false;
+    std::atomic<bool> alive = true;
+  };
+
+  std::shared_ptr<State> state_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,92 @@
+#pragma once
+
+#include <fmt/format.h>
+
+#include <iterator>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * A format string of the config, parsed once into literal text and replacement fields.
+ *
+ * The syntax is the one of fmt, without nested replacement fields in format specs. Rendering
+ * asks a lookup callback for the value of each field in turn, so values of placeholders the
+ * format doesn't reference are never computed, and only the spec of each field is left for fmt
+ * to parse. Positional fields, `{}` or `{0}`, are looked up by their index as a name.
+ */
+class FormatTemplate {
+ public:
+  // Formats the value of one field into the output
+  class Writer {
+   public:
+    template <typename T>
+    void write(const T& value) {
+      if (spec_.empty()) {
+        fmt::format_to(std::back_inserter(out_), "{}", value);
+      } else {
+        fmt::vformat_to(std::back_inserter(out_), spec_, fmt::make_format_args(value));
+      }
+      written_ = true;
+    }
+
+   private:
+    friend class FormatTemplate;
+    Writer(std::string& out, const std::string& spec) : out_(out), spec_(spec) {}
+
+    std::string& out_;
+    const std::string& spec_;
+    bool written_ = false;
+  };
+
+  // Throws fmt::format_error if the format is malformed
+  explicit FormatTemplate(std::string_view format);
+
+  bool empty() const { return fields_.empty() && text_.empty(); }
+  bool references(std::string_view name) const;
+
+  /**
+   * Renders the format into `out`, which is cleared first. `lookup(name, writer)` has to write
+   * the value of the field `name`; fmt::format_error is thrown if it doesn't.
+   */
+  template <typename Lookup>
+  void renderTo(std::string& out, Lookup&& lookup) const {
+    out.clear();
+    size_t text = 0;
+    for (const auto& field : fields_) {
+      out.append(text_, text, field.text_end - text);
+      text = field.text_end;
+      Writer writer(out, field.spec);
+      lookup(std::string_view(field.name), writer);
+      if (!writer.written_) {
+        throw fmt::format_error("argument not found: " + field.name);
+      }
+    }
+    out.append(text_, text);
+  }
+
+  // Renders into a buffer owned by the template, valid until the next render
+  template <typename Lookup>
+  const std::string& render(Lookup&& lookup) const {
+    renderTo(buffer_, std::forward<Lookup>(lookup));
+    return buffer_;
+  }
+
+ private:
+  struct Field {
+    // end of the literal text preceding the field in text_
+    size_t text_end;
+    std::string name;
+    // "{:<spec>}", empty without spec
+    std::string spec;
+  };
+
+  // literal text of the whole format, with escaped braces resolved
+  std::string text_;
+  std::vector<Field> fields_;
+  mutable std::string buffer_;
+};
+
+}  // namespace waybar::util
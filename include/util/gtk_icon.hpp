@@ -1,9 +1,16 @@
 #pragma once
+#include <cairomm/surface.h>
 #include <gtkmm/icontheme.h>
+#include <sigc++/signal.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <map>
 #include <mutex>
 #include <string>
 
+#include "util/lru_cache.hpp"
+
 class DefaultGtkIconThemeWrapper {
  private:
   static std::mutex default_theme_mutex;
@@ -12,3 +19,60 @@ class DefaultGtkIconThemeWrapper {
   static bool has_icon(const std::string&);
   static Glib::RefPtr<Gdk::Pixbuf> load_icon(const char*, int, Gtk::IconLookupFlags);
 };
+
+namespace waybar::util {
+
+/**
+ * Process-wide cache of rendered icons, shared by all modules, bars and outputs.
+ *
+ * Icons are rendered once per theme, name, size and scale factor into a surface that is ready
+ * to be set on a Gtk::Image, which takes a reference to it. Lookups that found no icon are
+ * cached as well. The cache is cleared when an icon theme changes.
+ */
+class IconCache {
+ public:
+  struct Stats {
+    size_t size;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+  };
+
+  static constexpr size_t kCacheSize = 256;
+
+  static IconCache& inst();
+
+  IconCache(const IconCache&) = delete;
+  IconCache& operator=(const IconCache&) = delete;
+  ~IconCache();
+
+  // The theme of that name, shared by all its users; the default theme for an empty name
+  Glib::RefPtr<Gtk::IconTheme> theme(const std::string& name);
+
+  /**
+   * Icon `name` from `theme`, which must come from theme(), or from the image file at path
+   * `name`. The surface is `size` device pixels high and keeps the aspect ratio of the icon.
+   * nullptr if there is no such icon.
+   */
+  Cairo::RefPtr<Cairo::Surface> load(const Glib::RefPtr<Gtk::IconTheme>& theme,
+                                     const std::string& name, int size, int scale);
+
+  Stats stats();
+
+  // Emitted on the main thread once the cache was cleared for a theme change
+  sigc::signal<void()>& signal_changed() { return signal_changed_; }
+
+ private:
+  IconCache();
+  void watch(const Glib::RefPtr<Gtk::IconTheme>& theme);
+  void clear();
+
+  std::mutex mutex_;
+  LruCache<std::string, Cairo::RefPtr<Cairo::Surface>> cache_;
+  std::map<std::string, Glib::RefPtr<Gtk::IconTheme>> themes_;
+  // bumped on every clear
+  uint64_t generation_ = 0;
+  sigc::signal<void()> signal_changed_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * The last `capacity` samples of a metric, e.g. for drawing a graph of it.
+ *
+ * Storage is allocated once by the constructor. Minimum, maximum, average and an exponentially
+ * weighted moving average over the window are maintained on every push in amortized O(1).
+ */
+class History {
+ public:
+  explicit History(size_t capacity);
+
+  void push(float value);
+
+  size_t size() const { return size_; }
+  size_t capacity() const { return values_.size(); }
+  bool empty() const { return size_ == 0; }
+  // i-th sample of the window, the oldest one first
+  float operator[](size_t i) const;
+
+  // All of these are 0 while the history is empty
+  float min() const;
+  float max() const;
+  float avg() const;
+  // Smoothing factor is 2 / (capacity + 1), as for a moving average of the same window
+  float ewma() const { return ewma_; }
+
+  // One block character per sample, scaled from `lo` to `hi` and left-padded with spaces up to
+  // the capacity so that the newest sample is always on the right
+  std::string sparkline(float lo, float hi) const;
+
+ private:
+  // Sample numbers whose values are monotonic, the extremum of the window at the front
+  class MonotonicQueue {
+   public:
+    explicit MonotonicQueue(size_t capacity) : numbers_(capacity) {}
+    template <typename Dominates>
+    void push(uint64_t number, const std::vector<float>& values, Dominates dominates);
+    void expire(uint64_t first);
+    uint64_t front() const { return numbers_[head_]; }
+    bool empty() const { return size_ == 0; }
+
+   private:
+    std::vector<uint64_t> numbers_;
+    size_t head_ = 0;
+    size_t size_ = 0;
+  };
+
+  float at(uint64_t number) const { return values_[number % values_.size()]; }
+
+  std::vector<float> values_;
+  size_t size_ = 0;
+  // number of samples pushed so far
+  uint64_t count_ = 0;
+  double sum_ = 0;
+  float alpha_;
+  float ewma_ = 0;
+  MonotonicQueue min_;
+  MonotonicQueue max_;
+};
+
+// Length of the histories of a module, from its "graph-length" option
+size_t graphLength(const Json::Value& config);
+
+}  // namespace waybar::util
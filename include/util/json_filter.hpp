@@ -0,0 +1,33 @@
+#pragma once
+
+#include <json/value.h>
+
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * JSON parser that only materializes the object members it is asked for.
+ *
+ * Members whose name isn't in `keys` are skipped without allocating, at any depth; array
+ * elements are always kept. This is meant for large replies like sway's IPC_GET_TREE, of which
+ * a module only reads a handful of fields per node.
+ */
+class JsonFilter {
+ public:
+  JsonFilter(std::initializer_list<std::string_view> keys);
+
+  Json::Value parse(std::string_view data) const;
+
+ private:
+  class Reader;
+
+  bool wanted(std::string_view key) const;
+
+  std::vector<std::string> keys_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * A procfs or sysfs file that stays open and is reread with pread() into a reusable buffer.
+ *
+ * Compared to opening an ifstream on every interval this saves the open/close syscalls and all
+ * allocations once the buffer has grown to the size of the file.
+ */
+class ProcFile {
+ public:
+  explicit ProcFile(std::string path);
+  ProcFile(const ProcFile&) = delete;
+  ProcFile& operator=(const ProcFile&) = delete;
+  ProcFile(ProcFile&& other) noexcept;
+  ProcFile& operator=(ProcFile&& other) noexcept;
+  ~ProcFile();
+
+  // Contents of the file, valid until the next call. Throws if the file can't be opened or read.
+  std::string_view read();
+  const std::string& path() const { return path_; }
+
+ private:
+  void close();
+
+  std::string path_;
+  int fd_ = -1;
+  std::vector<char> buffer_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace waybar::util {
+
+// Cumulative idle and total times per cpu, index 0 holds the sum of all cpus
+struct CpuTimes {
+  std::vector<uint64_t> idle;
+  std::vector<uint64_t> total;
+};
+
+/**
+ * Parses the cpu lines of /proc/stat into `times`, in place and reusing its storage, so that a
+ * tick allocates nothing once the vectors have the size of the cpu count.
+ */
+void parseProcStat(std::string_view data, CpuTimes& times);
+
+}  // namespace waybar::util
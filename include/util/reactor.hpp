@@ -0,0 +1,189 @@
+#pragma once
+
+#include <sys/types.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "util/command.hpp"
+
+namespace waybar::util {
+
+class Reactor;
+
+/**
+ * Handle for a child process run by the Reactor.
+ *
+ * Destroying or reassigning the handle terminates the process and drops its callbacks. Like for
+ * a Timer, cancellation waits for a running callback to return.
+ */
+class Process {
+ public:
+  Process() = default;
+  Process(const Process&) = delete;
+  Process& operator=(const Process&) = delete;
+  Process(Process&& other) noexcept;
+  Process& operator=(Process&& other) noexcept;
+  ~Process() { cancel(); }
+
+  void cancel();
+  // Whether the process, or one of its steps, is still running
+  bool running() const;
+  // Stops tracking the process without terminating it. Its callbacks no longer run.
+  void detach();
+  explicit operator bool() const { return id_ != 0; }
+
+ private:
+  friend class Reactor;
+  Process(Reactor* reactor, uint64_t id) : reactor_(reactor), id_(id) {}
+
+  Reactor* reactor_ = nullptr;
+  uint64_t id_ = 0;
+};
+
+/**
+ * Process-wide reactor for the child processes of modules.
+ *
+ * A single thread polls the output pipes of all children, non-blocking, and their pidfds for
+ * their exit, where pidfd_open is available; elsewhere exits are polled once the output is
+ * closed. Callbacks run on the reactor thread and must not block; use `dp.emit()` to move the
+ * actual work to the main loop.
+ */
+class Reactor {
+ public:
+  // Exit code and output as command::exec returns them, the output is empty for streams
+  using Done = std::function<void(command::res)>;
+  using Line = std::function<void(std::string_view)>;
+
+  struct Step {
+    // Without a command, the step only decides on the result of the previous one
+    std::string cmd;
+    /**
+     * Whether to go on with the next step, by default if the exit code is 0. It runs on the
+     * reactor thread, possibly with the reactor locked, and must not start processes.
+     */
+    std::function<bool(const command::res&)> proceed;
+  };
+
+  struct Stats {
+    uint64_t spawned;
+    uint64_t failed;
+    // time spent starting processes, in the threads that start them
+    std::chrono::nanoseconds spawn_time;
+    std::chrono::nanoseconds max_spawn_time;
+  };
+
+  static Reactor& inst();
+
+  /**
+   * Runs the steps one after the other, as long as they proceed, and passes the result of the
+   * last command that ran to `done`; that is {0, ""} if there was none, and {-1, ""} if one
+   * couldn't be started. If no process is started at all, `done` runs right away.
+   */
+  Process exec(std::vector<Step> steps, const command::limits& limits, Done done);
+
+  // Runs `cmd`, passing each line of its output to `line` as it comes, then its exit code to `done`
+  Process stream(const std::string& cmd, Line line, Done done);
+
+  // Runs `cmd` with the output of the bar, and passes its exit code to `done`
+  Process spawn(const std::string& cmd, Done done);
+
+  Stats stats() const;
+
+  ~Reactor();
+
+ private:
+  friend class Process;
+
+  struct Child {
+    std::vector<Step> steps;
+    // the step after the running one
+    size_t step = 0;
+    std::string cmd;
+    command::limits limits;
+    bool streaming = false;
+    bool inherit_output = false;
+    Line line;
+    Done done;
+
+    pid_t pid = -1;
+    int out = -1;
+    int pidfd = -1;
+    // indexes of out and pidfd in the poll set, -1 if not polled
+    int out_index = -1;
+    int pidfd_index = -1;
+    std::chrono::steady_clock::time_point deadline;
+    bool exited = false;
+    int status = 0;
+    bool killed = false;
+    // SIGKILL follows at this time, for children that don't exit on SIGTERM
+    std::chrono::steady_clock::time_point kill_deadline;
+    bool force_killed = false;
+    bool cancelled = false;
+    // left running, without callbacks
+    bool detached = false;
+    bool finished = false;
+    std::string output;
+  };
+
+  Reactor();
+  // Both return the pid of the started process, or -1. They don't publish it to other threads.
+  pid_t start(Child& child);
+  // `last` is the result of the step before, {-1, ""} if the next one couldn't be started
+  pid_t startNext(Child& child, command::res& last);
+  Process add(std::shared_ptr<Child> child);
+  void cancel(uint64_t id);
+  void detach(uint64_t id);
+  bool running(uint64_t id);
+  void run();
+  void readOutput(uint64_t id, const std::shared_ptr<Child>& child);
+  void reap(Child& child);
+  void kill(Child& child);
+  void wake();
+
+  struct Callback {
+    uint64_t id;
+    std::shared_ptr<Child> child;
+    // the result for done, a line otherwise
+    bool done;
+    std::string line;
+    command::res result;
+  };
+
+  // A next step to start
+  struct Start {
+    uint64_t id;
+    std::shared_ptr<Child> child;
+    command::res last;
+    pid_t pid;
+  };
+
+  std::unordered_map<uint64_t, std::shared_ptr<Child>> children_;
+  std::vector<Callback> callbacks_;
+  std::vector<Start> starting_;
+  std::array<char, 64 * 1024> buffer_;
+  uint64_t next_id_ = 1;
+  std::atomic<uint64_t> spawned_ = 0;
+  std::atomic<uint64_t> failed_ = 0;
+  std::atomic<int64_t> spawn_ns_ = 0;
+  std::atomic<int64_t> max_spawn_ns_ = 0;
+  uint64_t running_ = 0;
+  bool do_run_ = true;
+  int wake_fd_;
+  std::mutex mutex_;
+  std::condition_variable idle_cv_;
+  std::thread thread_;
+};
+
+}  // namespace waybar::util
@@ -1,10 +1,53 @@
 #pragma once
 #include <json/json.h>
 
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 
 namespace waybar::util {
 std::string rewriteString(const std::string&, const Json::Value&);
 std::string rewriteStringOnce(const std::string& value, const Json::Value& rules,
                               bool& matched_any);
+
+/**
+ * The rules of a `rewrite` config object, compiled once.
+ *
+ * Keys are case-insensitive regular expressions matched against the whole input, values their
+ * replacements. Invalid rules are logged and skipped. Identical rules, as every bar gets from the
+ * same config, share one compiled set. Results for all rule sets go to one process-wide LRU cache,
+ * as the same few window titles come up over and over. Safe to use from any thread.
+ */
+class RewriteRules {
+ public:
+  struct CacheStats {
+    size_t size;
+    size_t capacity;
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+  };
+
+  // Entries of the result cache, shared by all rule sets
+  static constexpr size_t kCacheSize = 512;
+
+  RewriteRules() = default;
+  explicit RewriteRules(const Json::Value& rules);
+
+  bool empty() const;
+
+  // Applies every matching rule in turn, like rewriteString
+  std::string apply(const std::string& value) const;
+  // Applies the first matching rule, like rewriteStringOnce
+  std::string applyOnce(const std::string& value, bool& matched_any) const;
+
+  static CacheStats cacheStats();
+
+ private:
+  struct RuleSet;
+
+  std::shared_ptr<const RuleSet> rules_;
+};
+
 }  // namespace waybar::util
@@ -0,0 +1,263 @@
+#pragma once
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "util/scheduler.hpp"
+
+namespace waybar::util {
+
+/**
+ * Periodic sampling of a kernel source shared by all modules reading it, on all bars.
+ *
+ * Samplers are keyed by name (e.g. "cpu" or the path of a sysfs file). The source is read once
+ * per tick on the scheduler thread, at the shortest interval of all subscriptions, and published
+ * as an immutable snapshot that readers load without locking. Each subscriber is notified at its
+ * own interval. Snapshot storage is reused once no reader holds it anymore, so readers that fill
+ * the sample in place don't allocate per tick.
+ *
+ * Sources that may block for long, such as a hung network filesystem, are read on a thread of
+ * their own instead, so that they don't hold up the other timers of the scheduler.
+ */
+template <typename T>
+class Sampler : public std::enable_shared_from_this<Sampler<T>> {
+ public:
+  using Snapshot = std::shared_ptr<const T>;
+  // Fills a sample in place, reusing its storage. If it throws the previous snapshot is kept.
+  using Reader = std::function<void(T&)>;
+  using Callback = std::function<void()>;
+
+  class Subscription {
+   public:
+    Subscription() = default;
+    Subscription(const Subscription&) = delete;
+    Subscription& operator=(const Subscription&) = delete;
+    Subscription(Subscription&& other) noexcept
+        : sampler_(std::move(other.sampler_)), id_(other.id_) {}
+    Subscription& operator=(Subscription&& other) noexcept {
+      if (this != &other) {
+        reset();
+        sampler_ = std::move(other.sampler_);
+        id_ = other.id_;
+      }
+      return *this;
+    }
+    ~Subscription() { reset(); }
+
+    // Latest snapshot, never null after subscribing
+    Snapshot latest() const { return sampler_->latest(); }
+
+    // No more callbacks once this returns
+    void reset() {
+      if (sampler_) sampler_->unsubscribe(id_);
+      sampler_.reset();
+    }
+
+   private:
+    friend class Sampler;
+    Subscription(std::shared_ptr<Sampler> sampler, uint64_t id)
+        : sampler_(std::move(sampler)), id_(id) {}
+
+    std::shared_ptr<Sampler> sampler_;
+    uint64_t id_ = 0;
+  };
+
+  /**
+   * Sampler shared by every caller passing the same key. `makeReader` is only called when the
+   * sampler doesn't exist yet. The first sample is taken synchronously, so that subscribers have
+   * a baseline right away; exceptions of the reader are passed on. A `blocking` reader runs on its
+   * own thread, its first snapshot is a default constructed T until the first read is done.
+   */
+  static std::shared_ptr<Sampler> get(const std::string& key,
+                                      const std::function<Reader()>& makeReader,
+                                      bool blocking = false) {
+    static std::mutex mutex;
+    static std::map<std::string, std::weak_ptr<Sampler>> samplers;
+    std::lock_guard<std::mutex> lock(mutex);
+    auto& weak = samplers[key];
+    auto sampler = weak.lock();
+    if (!sampler) {
+      sampler = std::shared_ptr<Sampler>(new Sampler(makeReader(), blocking));
+      if (blocking) {
+        sampler->startWorker();
+      }
+      weak = sampler;
+    }
+    return sampler;
+  }
+
+  ~Sampler() {
+    timer_.cancel();
+    if (worker_) {
+      // The thread exits on its own, once a read that is stuck returns
+      std::lock_guard<std::mutex> lock(worker_->mutex);
+      worker_->stop = true;
+      worker_->cv.notify_one();
+    }
+  }
+
+  // `callback` runs on the scheduler thread after a new snapshot was published, so it must not
+  // block; use `dp.emit()` to move the actual work to the main loop.
+  Subscription subscribe(std::chrono::milliseconds interval, Callback callback) {
+    uint64_t id;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      id = next_id_++;
+      subscribers_.push_back({id, interval, std::move(callback), {}});
+    }
+    reschedule();
+    return Subscription(this->shared_from_this(), id);
+  }
+
+  Snapshot latest() const { return std::atomic_load(&latest_); }
+
+ private:
+  struct Subscriber {
+    uint64_t id;
+    std::chrono::milliseconds interval;
+    Callback callback;
+    Scheduler::clock::time_point due;
+  };
+
+  // State shared with the thread of a blocking reader, which may outlive the sampler
+  struct Worker {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool requested = false;
+    bool stop = false;
+  };
+
+  Sampler(Reader reader, bool blocking) : reader_(std::move(reader)) {
+    std::lock_guard<std::mutex> lock(read_mutex_);
+    if (blocking) {
+      current_ = std::make_shared<T>();
+      latest_ = current_;
+    } else {
+      sample();
+    }
+  }
+
+  void startWorker() {
+    worker_ = std::make_shared<Worker>();
+    std::thread([worker = worker_, weak = this->weak_from_this()] {
+      std::unique_lock<std::mutex> lock(worker->mutex);
+      for (;;) {
+        worker->cv.wait(lock, [&worker] { return worker->requested || worker->stop; });
+        if (worker->stop) return;
+        worker->requested = false;
+        lock.unlock();
+        if (auto sampler = weak.lock()) {
+          sampler->tick();
+        }
+        lock.lock();
+      }
+    }).detach();
+  }
+
+  // Ticks of a blocking reader are passed on to its thread, and merged while it is busy
+  void requestTick() {
+    if (!worker_) {
+      tick();
+      return;
+    }
+    std::lock_guard<std::mutex> lock(worker_->mutex);
+    worker_->requested = true;
+    worker_->cv.notify_one();
+  }
+
+  // Reads the source into the spare storage if no reader holds it anymore, else into a new one
+  void sample() {
+    auto next = spare_.use_count() == 1 ? std::move(spare_) : std::make_shared<T>();
+    try {
+      reader_(*next);
+    } catch (...) {
+      spare_ = std::move(next);
+      throw;
+    }
+    std::atomic_store(&latest_, Snapshot(next));
+    spare_ = std::move(current_);
+    current_ = std::move(next);
+  }
+
+  void tick() {
+    {
+      std::lock_guard<std::mutex> lock(read_mutex_);
+      try {
+        sample();
+      } catch (const std::exception& e) {
+        // Subscribers keep the previous snapshot
+        spdlog::debug("sampler: {}", e.what());
+      }
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    const auto now = Scheduler::clock::now();
+    for (auto& subscriber : subscribers_) {
+      // Ticks don't line up with every interval, don't skip one for being a bit early
+      if (subscriber.due - tick_interval_.value_or(subscriber.interval) / 2 <= now) {
+        subscriber.due = now + subscriber.interval;
+        subscriber.callback();
+      }
+    }
+  }
+
+  void unsubscribe(uint64_t id) {
+    {
+      // Also waits for a tick in progress, so the callback isn't called anymore afterwards
+      std::lock_guard<std::mutex> lock(mutex_);
+      subscribers_.erase(std::remove_if(subscribers_.begin(), subscribers_.end(),
+                                        [id](const auto& s) { return s.id == id; }),
+                         subscribers_.end());
+    }
+    reschedule();
+  }
+
+  // Runs the timer at the shortest interval of all subscribers
+  void reschedule() {
+    std::lock_guard<std::mutex> timer_lock(timer_mutex_);
+    std::optional<std::chrono::milliseconds> interval;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      for (const auto& subscriber : subscribers_) {
+        interval = std::min(interval.value_or(subscriber.interval), subscriber.interval);
+      }
+      if (interval == tick_interval_) return;
+      tick_interval_ = interval;
+    }
+    // Cancelling waits for a running tick, which needs mutex_
+    timer_.cancel();
+    if (interval) {
+      timer_ = Scheduler::inst().every(*interval, [this] { requestTick(); });
+    }
+  }
+
+  Reader reader_;
+  // Serializes reads, which don't hold up subscribing and unsubscribing meanwhile
+  std::mutex read_mutex_;
+  std::shared_ptr<Worker> worker_;
+  std::mutex mutex_;
+  Snapshot latest_;
+  // mutable aliases of the published snapshot and of the one before
+  std::shared_ptr<T> current_;
+  std::shared_ptr<T> spare_;
+  std::vector<Subscriber> subscribers_;
+  uint64_t next_id_ = 1;
+
+  std::mutex timer_mutex_;
+  std::optional<std::chrono::milliseconds> tick_interval_;
+  Timer timer_;
+};
+
+}  // namespace waybar::util
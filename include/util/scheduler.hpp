@@ -0,0 +1,114 @@
+#pragma once
+
+#include <sigc++/connection.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace waybar::util {
+
+class Scheduler;
+
+/**
+ * Handle for a periodic task registered with the Scheduler.
+ *
+ * The task is cancelled when the handle is destroyed or reassigned. Cancellation waits for a
+ * running callback to return, so it is safe to destroy the handle before the data captured by
+ * the callback.
+ */
+class Timer {
+ public:
+  Timer() = default;
+  Timer(const Timer&) = delete;
+  Timer& operator=(const Timer&) = delete;
+  Timer(Timer&& other) noexcept;
+  Timer& operator=(Timer&& other) noexcept;
+  ~Timer() { cancel(); }
+
+  // Run the callback as soon as possible and restart the interval from there
+  void wake_up();
+  void cancel();
+  explicit operator bool() const { return id_ != 0; }
+
+ private:
+  friend class Scheduler;
+  Timer(Scheduler* scheduler, uint64_t id) : scheduler_(scheduler), id_(id) {}
+
+  Scheduler* scheduler_ = nullptr;
+  uint64_t id_ = 0;
+};
+
+/**
+ * Process-wide scheduler for interval driven work.
+ *
+ * A single thread sleeps until the earliest deadline of a min-heap of tasks. Every task may run
+ * up to `slack` after its deadline, which lets wakeups of tasks with nearby deadlines coalesce
+ * into one. Callbacks run on the scheduler thread and must not block; use `dp.emit()` to move the
+ * actual work to the main loop.
+ */
+class Scheduler {
+ public:
+  using clock = std::chrono::system_clock;
+  using Callback = std::function<void()>;
+
+  static Scheduler& inst();
+
+  /**
+   * Register a callback to run immediately and then every `interval`.
+   * When `aligned` is set, the following runs are aligned to multiples of `interval` since the
+   * epoch (e.g. full minutes for a clock). A zero interval runs the callback only once.
+   */
+  Timer every(clock::duration interval, Callback callback, bool aligned = false);
+
+  ~Scheduler();
+
+ private:
+  friend class Timer;
+
+  struct Task {
+    clock::duration interval;
+    clock::duration slack;
+    bool aligned;
+    Callback callback;
+    clock::time_point deadline{};
+    // incremented on reschedule, to discard stale heap entries
+    uint64_t generation = 0;
+  };
+
+  struct Entry {
+    clock::time_point deadline;
+    clock::time_point latest;
+    uint64_t id;
+    uint64_t generation;
+  };
+
+  Scheduler();
+  void run();
+  void cancel(uint64_t id);
+  void wake_up(uint64_t id);
+  void schedule(uint64_t id, Task& task, clock::time_point deadline);
+  void wakeAll();
+  static clock::duration defaultSlack(clock::duration interval);
+  static bool laterEntry(const Entry& a, const Entry& b);
+
+  std::unordered_map<uint64_t, std::shared_ptr<Task>> tasks_;
+  // min-heap on the latest acceptable run time
+  std::vector<Entry> heap_;
+  uint64_t next_id_ = 1;
+  uint64_t running_ = 0;
+  bool do_run_ = true;
+  std::mutex mutex_;
+  std::condition_variable wake_cv_;
+  std::condition_variable idle_cv_;
+  sigc::connection connection_;
+  std::thread thread_;
+};
+
+}  // namespace waybar::util
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <glibmm/main.h>
+#include <gtkmm/widget.h>
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+namespace waybar::util {
+
+/**
+ * Coalesces the update requests of the modules of a bar into one pass per frame.
+ *
+ * Updates scheduled any number of times run once, on the next tick of the frame clock of
+ * `widget`, so that a burst of events is laid out and drawn once. If no frame comes within
+ * `max_latency`, e.g. while the bar is unmapped, they run anyway. A zero `max_latency` runs
+ * updates right away.
+ */
+class UpdateBatcher {
+ public:
+  UpdateBatcher(Gtk::Widget& widget, std::chrono::milliseconds max_latency);
+  UpdateBatcher(const UpdateBatcher&) = delete;
+  UpdateBatcher& operator=(const UpdateBatcher&) = delete;
+  ~UpdateBatcher();
+
+  // Registers an update, returns the id to schedule it with
+  size_t add(std::function<void()> update);
+  void schedule(size_t id);
+
+ private:
+  void arm();
+  void flush();
+
+  Gtk::Widget& widget_;
+  const std::chrono::milliseconds max_latency_;
+  std::vector<std::function<void()>> updates_;
+  std::vector<bool> pending_;
+  // ids in the order they were scheduled, and the ones being run by flush()
+  std::vector<size_t> queue_;
+  std::vector<size_t> flushing_;
+  guint tick_id_ = 0;
+  sigc::connection timeout_;
+};
+
+}  // namespace waybar::util
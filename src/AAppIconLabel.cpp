@@ -22,8 +22,14 @@ AAppIconLabel::AAppIconLabel(const Json::Value& config, const std::string& name,
     app_icon_size_ = config["icon-size"].asUInt();
   }
   image_.set_pixel_size(app_icon_size_);
+  icon_theme_changed_ = util::IconCache::inst().signal_changed().connect(
+      sigc::mem_fun(*this, &AAppIconLabel::reloadAppIcon));
+  image_.property_scale_factor().signal_changed().connect(
+      sigc::mem_fun(*this, &AAppIconLabel::reloadAppIcon));
 }
 
+AAppIconLabel::~AAppIconLabel() { icon_theme_changed_.disconnect(); }
+
 std::optional<std::string> getDesktopFilePath(const std::string& app_identifier,
                                               const std::string& alternative_app_identifier) {
   const auto data_dirs = Glib::get_system_data_dirs();
@@ -119,12 +125,24 @@ void AAppIconLabel::updateAppIcon() {
     if (app_icon_name_.empty()) {
       image_.set_visible(false);
     } else {
-      image_.set_from_icon_name(app_icon_name_, Gtk::ICON_SIZE_INVALID);
+      const int scale = image_.get_scale_factor();
+      const int size = static_cast<int>(app_icon_size_) * scale;
+      if (auto surface = util::IconCache::inst().load(Gtk::IconTheme::get_default(),
+                                                      app_icon_name_, size, scale)) {
+        image_.set(surface);
+      } else {
+        image_.set_from_icon_name(app_icon_name_, Gtk::ICON_SIZE_INVALID);
+      }
       image_.set_visible(true);
     }
   }
 }
 
+void AAppIconLabel::reloadAppIcon() {
+  update_app_icon_ = true;
+  updateAppIcon();
+}
+
 auto AAppIconLabel::update() -> void {
   updateAppIcon();
   AIconLabel::update();
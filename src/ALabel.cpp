@@ -1,6 +1,7 @@
 #include "ALabel.hpp"
 
 #include <fmt/format.h>
+#include <spdlog/spdlog.h>
 
 #include <util/command.hpp>
 
@@ -49,10 +50,75 @@ ALabel::ALabel(const Json::Value& config, const std::string& name, const std::st
       label_.set_xalign(align);
     }
   }
+
+  // Compile the formats up front, so that modules can tell which placeholders they need.
+  // Malformed formats are reported once they are used.
+  auto compile = [this](const std::string& format) {
+    try {
+      getTemplate(format);
+    } catch (const fmt::format_error&) {
+    }
+  };
+  compile(format_);
+  for (auto it = config_.begin(); it != config_.end(); ++it) {
+    const auto key = it.name();
+    if (it->isString() && key != "format-icons" &&
+        (key.rfind("format", 0) == 0 || key.rfind("tooltip-format", 0) == 0)) {
+      compile(it->asString());
+    }
+  }
+}
+
+ALabel::~ALabel() {
+  spdlog::debug("{}: {} label updates applied, {} skipped as unchanged", name_, updates_applied_,
+                updates_skipped_);
 }
 
 auto ALabel::update() -> void { AModule::update(); }
 
+bool ALabel::setMarkup(const std::string& markup) {
+  if (markup_ == markup) {
+    ++updates_skipped_;
+    return false;
+  }
+  label_.set_markup(markup);
+  markup_ = markup;
+  ++updates_applied_;
+  return true;
+}
+
+void ALabel::setTooltipText(const std::string& text) { setTooltip(text, false); }
+
+void ALabel::setTooltipMarkup(const std::string& markup) { setTooltip(markup, true); }
+
+void ALabel::setTooltip(const std::string& tooltip, bool markup) {
+  if (tooltip_ == tooltip && tooltip_markup_ == markup) {
+    ++updates_skipped_;
+    return;
+  }
+  if (markup) {
+    label_.set_tooltip_markup(tooltip);
+  } else {
+    label_.set_tooltip_text(tooltip);
+  }
+  tooltip_ = tooltip;
+  tooltip_markup_ = markup;
+  ++updates_applied_;
+}
+
+void ALabel::setClass(const std::string& name, bool enabled) {
+  if (enabled == (classes_.count(name) != 0)) {
+    return;
+  }
+  if (enabled) {
+    label_.get_style_context()->add_class(name);
+    classes_.insert(name);
+  } else {
+    label_.get_style_context()->remove_class(name);
+    classes_.erase(name);
+  }
+}
+
 std::string ALabel::getIcon(uint16_t percentage, const std::string& alt, uint16_t max) {
   auto format_icons = config_["format-icons"];
   if (format_icons.isObject()) {
@@ -113,6 +179,19 @@ bool waybar::ALabel::handleToggle(GdkEventButton* const& e) {
   return AModule::handleToggle(e);
 }
 
+const util::FormatTemplate& ALabel::getTemplate(const std::string& format) {
+  auto it = templates_.find(format);
+  if (it == templates_.end()) {
+    it = templates_.emplace(format, util::FormatTemplate(format)).first;
+  }
+  return it->second;
+}
+
+bool ALabel::referenced(std::string_view name) const {
+  return std::any_of(templates_.begin(), templates_.end(),
+                     [name](const auto& entry) { return entry.second.references(name); });
+}
+
 std::string ALabel::getState(uint8_t value, bool lesser) {
   if (!config_["states"].isObject()) {
     return "";
@@ -133,10 +212,10 @@ std::string ALabel::getState(uint8_t value, bool lesser) {
   std::string valid_state;
   for (auto const& state : states) {
     if ((lesser ? value <= state.second : value >= state.second) && valid_state.empty()) {
-      label_.get_style_context()->add_class(state.first);
+      setClass(state.first, true);
       valid_state = state.first;
     } else {
-      label_.get_style_context()->remove_class(state.first);
+      setClass(state.first, false);
     }
   }
   return valid_state;
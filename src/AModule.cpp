@@ -2,16 +2,34 @@
 
 #include <fmt/format.h>
 
-#include <util/command.hpp>
+#include <util/reactor.hpp>
 
 namespace waybar {
 
+namespace {
+
+// User commands tracked per module; beyond that the oldest ones are left running on their own
+constexpr size_t kMaxChildren = 32;
+
+}  // namespace
+
 AModule::AModule(const Json::Value& config, const std::string& name, const std::string& id,
                  bool enable_click, bool enable_scroll)
     : name_(std::move(name)),
       config_(std::move(config)),
       distance_scrolled_y_(0.0),
       distance_scrolled_x_(0.0) {
+  command_exited_.connect([this](const std::string& event, int exit_code) {
+    if (event == "on-update") {
+      on_update_running_ = false;
+      if (on_update_pending_) {
+        on_update_pending_ = false;
+        runOnUpdate();
+      }
+    }
+    handleCommandExit(event, exit_code);
+  });
+
   // Configure module action Map
   const Json::Value actions{config_["actions"]};
   for (Json::Value::const_iterator it = actions.begin(); it != actions.end(); ++it) {
@@ -57,17 +75,48 @@ AModule::AModule(const Json::Value& config, const std::string& name, const std::
 }
 
 AModule::~AModule() {
-  for (const auto& pid : pid_) {
-    if (pid != -1) {
-      killpg(pid, SIGTERM);
-    }
-  }
+  spdlog::debug("{}: {} commands spawned, {} on-update runs coalesced", name_, spawned_,
+                coalesced_);
+  // Terminates the commands that are still running
+  on_update_.cancel();
+  children_.clear();
 }
 
 auto AModule::update() -> void {
   // Run user-provided update handler if configured
   if (config_["on-update"].isString()) {
-    pid_.push_back(util::command::forkExec(config_["on-update"].asString()));
+    runOnUpdate();
+  }
+}
+
+void AModule::runOnUpdate() {
+  // Updates while it runs are folded into one more run once it exited
+  if (on_update_running_) {
+    if (on_update_pending_) {
+      ++coalesced_;
+    }
+    on_update_pending_ = true;
+    return;
+  }
+  on_update_running_ = true;
+  ++spawned_;
+  on_update_ = util::Reactor::inst().spawn(
+      config_["on-update"].asString(),
+      [this](const util::command::res& result) { command_exited_("on-update", result.exit_code); });
+}
+
+void AModule::spawn(const std::string& event) {
+  std::erase_if(children_, [](const auto& child) { return !child.running(); });
+  if (children_.size() >= kMaxChildren) {
+    children_.front().detach();
+    children_.erase(children_.begin());
+  }
+  ++spawned_;
+  auto child = util::Reactor::inst().spawn(
+      config_[event].asString(),
+      [this, event](const util::command::res& result) { command_exited_(event, result.exit_code); });
+  if (child) {
+    children_.push_back(std::move(child));
   }
 }
 // Get mapping between event name and module action name
@@ -80,6 +129,12 @@ auto AModule::doAction(const std::string& name) -> void {
   }
 }
 
+void AModule::handleCommandExit(const std::string& event, int exit_code) {
+  if (exit_code != 0) {
+    spdlog::warn("{}: {} command exited with code {}", name_, event, exit_code);
+  }
+}
+
 bool AModule::handleToggle(GdkEventButton* const& e) { return handleUserEvent(e); }
 
 bool AModule::handleRelease(GdkEventButton* const& e) { return handleUserEvent(e); }
@@ -102,7 +157,7 @@ bool AModule::handleUserEvent(GdkEventButton* const& e) {
       format.clear();
   }
   if (!format.empty()) {
-    pid_.push_back(util::command::forkExec(format));
+    spawn(rec->second);
   }
   dp.emit();
   return true;
@@ -183,7 +238,7 @@ bool AModule::handleScroll(GdkEventScroll* e) {
   this->AModule::doAction(eventName);
   // Second call user scripts
   if (config_[eventName].isString())
-    pid_.push_back(util::command::forkExec(config_[eventName].asString()));
+    spawn(eventName);
 
   dp.emit();
   return true;
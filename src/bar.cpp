@@ -487,7 +487,10 @@ waybar::Bar::Bar(struct waybar_output* w_output, const Json::Value& w_config)
       left_(Gtk::ORIENTATION_HORIZONTAL, 0),
       center_(Gtk::ORIENTATION_HORIZONTAL, 0),
       right_(Gtk::ORIENTATION_HORIZONTAL, 0),
-      box_(Gtk::ORIENTATION_HORIZONTAL, 0) {
+      box_(Gtk::ORIENTATION_HORIZONTAL, 0),
+      updates_(window, std::chrono::milliseconds(config["max-update-latency"].isUInt()
+                                                     ? config["max-update-latency"].asUInt()
+                                                     : 50)) {
   window.set_title("waybar");
   window.set_name("waybar");
   window.set_decorated(false);
@@ -777,13 +780,14 @@ void waybar::Bar::getModules(const Factory& factory, const std::string& pos,
             modules_right_.emplace_back(module_sp);
           }
         }
-        module->dp.connect([module, ref] {
+        auto update = updates_.add([module, ref] {
           try {
             module->update();
           } catch (const std::exception& e) {
             spdlog::error("{}: {}", ref, e.what());
           }
         });
+        module->dp.connect([this, update] { updates_.schedule(update); });
       } catch (const std::exception& e) {
         spdlog::warn("module {}: {}", name.asString(), e.what());
       }
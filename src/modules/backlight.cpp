@@ -192,7 +192,7 @@ auto waybar::modules::Backlight::update() -> void {
           best->get_max() == 0 ? 100 : round(best->get_actual() * 100.0f / best->get_max());
       std::string desc = fmt::format(fmt::runtime(format_), fmt::arg("percent", percent),
                                      fmt::arg("icon", getIcon(percent)));
-      label_.set_markup(desc);
+      setMarkup(desc);
       getState(percent);
       if (tooltipEnabled()) {
         std::string tooltip_format;
@@ -200,11 +200,11 @@ auto waybar::modules::Backlight::update() -> void {
           tooltip_format = config_["tooltip-format"].asString();
         }
         if (!tooltip_format.empty()) {
-          label_.set_tooltip_text(fmt::format(fmt::runtime(tooltip_format),
-                                              fmt::arg("percent", percent),
-                                              fmt::arg("icon", getIcon(percent))));
+          setTooltipText(fmt::format(fmt::runtime(tooltip_format),
+                                     fmt::arg("percent", percent),
+                                     fmt::arg("icon", getIcon(percent))));
         } else {
-          label_.set_tooltip_text(desc);
+          setTooltipText(desc);
         }
       }
     } else {
@@ -214,7 +214,7 @@ auto waybar::modules::Backlight::update() -> void {
     if (!previous_best_.has_value()) {
       return;
     }
-    label_.set_markup("");
+    setMarkup("");
   }
   previous_best_ = best == nullptr ? std::nullopt : std::optional{*best};
   previous_format_ = format_;
@@ -28,6 +28,8 @@ waybar::modules::Battery::Battery(const std::string& id, const Json::Value& conf
 }
 
 waybar::modules::Battery::~Battery() {
+  // The timer callback uses the watch descriptors closed below
+  timer_.cancel();
 #if defined(__linux__)
   std::lock_guard<std::mutex> guard(battery_list_mutex_);
 
@@ -50,18 +52,14 @@ waybar::modules::Battery::~Battery() {
 
 void waybar::modules::Battery::worker() {
 #if defined(__FreeBSD__)
-  thread_timer_ = [this] {
-    dp.emit();
-    thread_timer_.sleep_for(interval_);
-  };
+  timer_ = util::Scheduler::inst().every(interval_, [this] { dp.emit(); });
 #else
-  thread_timer_ = [this] {
+  timer_ = util::Scheduler::inst().every(interval_, [this] {
     // Make sure we eventually update the list of batteries even if we miss an
     // inotify event for some reason
     refreshBatteries();
     dp.emit();
-    thread_timer_.sleep_for(interval_);
-  };
+  });
   thread_ = [this] {
     struct inotify_event event = {0};
     int nbytes = read(battery_watch_fd_, &event, sizeof(event));
@@ -619,9 +617,15 @@ const std::string waybar::modules::Battery::formatTimeRemaining(float hoursRemai
   if (config_["format-time"].isString()) {
     format = config_["format-time"].asString();
   }
-  std::string zero_pad_minutes = fmt::format("{:02d}", minutes);
-  return fmt::format(fmt::runtime(format), fmt::arg("H", full_hours), fmt::arg("M", minutes),
-                     fmt::arg("m", zero_pad_minutes));
+  return getTemplate(format).render([&](std::string_view name, util::FormatTemplate::Writer& out) {
+    if (name == "H") {
+      out.write(full_hours);
+    } else if (name == "M") {
+      out.write(minutes);
+    } else if (name == "m") {
+      out.write(fmt::format("{:02d}", minutes));
+    }
+  });
 }
 
 auto waybar::modules::Battery::update() -> void {
@@ -642,8 +646,22 @@ auto waybar::modules::Battery::update() -> void {
   auto format = format_;
   auto state = getState(capacity, true);
   auto time_remaining_formatted = formatTimeRemaining(time_remaining);
+  auto icons = std::vector<std::string>{status + "-" + state, status, state};
+  std::string tooltip_text_default;
+  auto lookup = [&](std::string_view name, util::FormatTemplate::Writer& out) {
+    if (name == "capacity") {
+      out.write(capacity);
+    } else if (name == "power") {
+      out.write(power);
+    } else if (name == "icon") {
+      out.write(getIcon(capacity, icons));
+    } else if (name == "time") {
+      out.write(time_remaining_formatted);
+    } else if (name == "timeTo") {
+      out.write(tooltip_text_default);
+    }
+  };
   if (tooltipEnabled()) {
-    std::string tooltip_text_default;
     std::string tooltip_format = "{timeTo}";
     if (time_remaining != 0) {
       std::string time_to = std::string("Time to ") + ((time_remaining > 0) ? "empty" : "full");
@@ -660,15 +678,12 @@ auto waybar::modules::Battery::update() -> void {
     } else if (config_["tooltip-format"].isString()) {
       tooltip_format = config_["tooltip-format"].asString();
     }
-    label_.set_tooltip_text(fmt::format(fmt::runtime(tooltip_format),
-                                        fmt::arg("timeTo", tooltip_text_default),
-                                        fmt::arg("power", power), fmt::arg("capacity", capacity),
-                                        fmt::arg("time", time_remaining_formatted)));
+    setTooltipText(getTemplate(tooltip_format).render(lookup));
   }
-  if (!old_status_.empty()) {
-    label_.get_style_context()->remove_class(old_status_);
+  if (!old_status_.empty() && old_status_ != status) {
+    setClass(old_status_, false);
   }
-  label_.get_style_context()->add_class(status);
+  setClass(status, true);
   old_status_ = status;
   if (!state.empty() && config_["format-" + status + "-" + state].isString()) {
     format = config_["format-" + status + "-" + state].asString();
@@ -681,10 +696,7 @@ auto waybar::modules::Battery::update() -> void {
     event_box_.hide();
   } else {
     event_box_.show();
-    auto icons = std::vector<std::string>{status + "-" + state, status, state};
-    label_.set_markup(fmt::format(
-        fmt::runtime(format), fmt::arg("capacity", capacity), fmt::arg("power", power),
-        fmt::arg("icon", getIcon(capacity, icons)), fmt::arg("time", time_remaining_formatted)));
+    setMarkup(getTemplate(format).render(lookup));
   }
   // Call parent update
   ALabel::update();
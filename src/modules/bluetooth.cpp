@@ -193,27 +193,20 @@ auto waybar::modules::Bluetooth::update() -> void {
     tooltip_format = config_["tooltip-format"].asString();
   }
 
-  auto update_style_context = [this](const std::string& style_class, bool in_next_state) {
-    if (in_next_state && !label_.get_style_context()->has_class(style_class)) {
-      label_.get_style_context()->add_class(style_class);
-    } else if (!in_next_state && label_.get_style_context()->has_class(style_class)) {
-      label_.get_style_context()->remove_class(style_class);
-    }
-  };
-  update_style_context("discoverable", cur_controller_ ? cur_controller_->discoverable : false);
-  update_style_context("discovering", cur_controller_ ? cur_controller_->discovering : false);
-  update_style_context("pairable", cur_controller_ ? cur_controller_->pairable : false);
+  setClass("discoverable", cur_controller_ ? cur_controller_->discoverable : false);
+  setClass("discovering", cur_controller_ ? cur_controller_->discovering : false);
+  setClass("pairable", cur_controller_ ? cur_controller_->pairable : false);
   if (!state_.empty()) {
-    update_style_context(state_, false);
+    setClass(state_, false);
   }
-  update_style_context(state, true);
+  setClass(state, true);
   state_ = state;
 
   if (format_.empty()) {
     event_box_.hide();
   } else {
     event_box_.show();
-    label_.set_markup(fmt::format(
+    setMarkup(fmt::format(
         fmt::runtime(format_), fmt::arg("status", state_),
         fmt::arg("num_connections", connected_devices_.size()),
         fmt::arg("controller_address", cur_controller_ ? cur_controller_->address : "null"),
@@ -258,7 +251,7 @@ auto waybar::modules::Bluetooth::update() -> void {
         device_enumerate_.erase(0, 1);
       }
     }
-    label_.set_tooltip_text(fmt::format(
+    setTooltipText(fmt::format(
         fmt::runtime(tooltip_format), fmt::arg("status", state_),
         fmt::arg("num_connections", connected_devices_.size()),
         fmt::arg("controller_address", cur_controller_ ? cur_controller_->address : "null"),
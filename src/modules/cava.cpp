@@ -173,7 +173,7 @@ auto waybar::modules::Cava::update() -> void {
         if (prm_.bar_delim != 0) text_.push_back(prm_.bar_delim);
       }
 
-      label_.set_markup(text_);
+      setMarkup(text_);
       ALabel::update();
     }
   } else
@@ -147,14 +147,8 @@ waybar::modules::Clock::Clock(const std::string& id, const Json::Value& config)
   else
     locale_ = std::locale("");
 
-  thread_ = [this] {
-    dp.emit();
-    auto now = std::chrono::system_clock::now();
-    /* difference with projected wakeup time */
-    auto diff = now.time_since_epoch() % interval_;
-    /* sleep until the next projected time */
-    thread_.sleep_for(interval_ - diff);
-  };
+  /* wake up on multiples of the interval */
+  timer_ = util::Scheduler::inst().every(interval_, [this] { dp.emit(); }, true);
 }
 
 const date::time_zone* waybar::modules::Clock::current_timezone() {
@@ -175,7 +169,7 @@ auto waybar::modules::Clock::update() -> void {
       tz, date::local_days(shiftedDay) +
               (now.get_local_time() - date::floor<date::days>(now.get_local_time())))};
 
-  label_.set_markup(fmt::format(locale_, fmt::runtime(format_), now));
+  setMarkup(fmt::format(locale_, fmt::runtime(format_), now));
 
   if (tooltipEnabled()) {
     const std::string tz_text{(is_timezoned_list_in_tooltip_) ? timezones_text(now.get_sys_time())
@@ -186,7 +180,7 @@ auto waybar::modules::Clock::update() -> void {
     const std::string text{fmt::format(locale_, fmt::runtime(fmtMap_[5]), shiftedNow,
                                        fmt::arg(KTimezonedTimeListPlaceholder.c_str(), tz_text),
                                        fmt::arg(kCalendarPlaceholder.c_str(), cld_text))};
-    label_.set_tooltip_markup(text);
+    setTooltipMarkup(text);
   }
 
   // Call parent update
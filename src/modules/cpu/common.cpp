@@ -1,32 +1,46 @@
 #include "modules/cpu.hpp"
 
-// In the 80000 version of fmt library authors decided to optimize imports
-// and moved declarations required for fmt::dynamic_format_arg_store in new
-// header fmt/args.h
-#if (FMT_VERSION >= 80000)
-#include <fmt/args.h>
-#else
-#include <fmt/core.h>
-#endif
+#include <charconv>
+#include <string_view>
+#include <tuple>
+
+namespace {
+// Usage over fewer jiffies than this is mostly 0% or 100%. The first tick of the sampler follows
+// the baseline of the constructor right away.
+constexpr float kMinDeltaJiffies = 10;
+}  // namespace
 
 waybar::modules::Cpu::Cpu(const std::string& id, const Json::Value& config)
-    : ALabel(config, "cpu", id, "{usage}%", 10) {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+    : ALabel(config, "cpu", id, "{usage}%", 10), usage_history_(util::graphLength(config)) {
+  const bool frequencies = referenced("max_frequency") || referenced("min_frequency") ||
+                           referenced("avg_frequency");
+  auto sampler = util::Sampler<Sample>::get(frequencies ? "cpu:frequency" : "cpu", [frequencies] {
+    return [reader = std::make_shared<Reader>(frequencies)](Sample& sample) {
+      reader->read(sample);
+    };
+  });
+  // Baseline for the first usage sample, so that it doesn't have to wait for a second one
+  prev_sample_ = sampler->latest();
+  sampler_ = sampler->subscribe(interval_, [this] { dp.emit(); });
 }
 
 auto waybar::modules::Cpu::update() -> void {
-  // TODO: as creating dynamic fmt::arg arrays is buggy we have to calc both
-  auto cpu_load = getCpuLoad();
-  auto [cpu_usage, tooltip] = getCpuUsage();
-  auto [max_frequency, min_frequency, avg_frequency] = getCpuFrequency();
+  const auto sample = sampler_.latest();
+  // Updates on clicks don't bring a new sample, keep the usage of the last one
+  const bool new_sample = sample != prev_sample_;
+  if (new_sample || usage_.empty()) {
+    std::tie(usage_, usage_tooltip_) = getCpuUsage(prev_sample_->times, sample->times);
+  }
+  prev_sample_ = sample;
+  const auto& cpu_usage = usage_;
   if (tooltipEnabled()) {
-    label_.set_tooltip_text(tooltip);
+    setTooltipText(usage_tooltip_);
   }
   auto format = format_;
   auto total_usage = cpu_usage.empty() ? 0 : cpu_usage[0];
+  if (new_sample) {
+    usage_history_.push(total_usage);
+  }
   auto state = getState(total_usage);
   if (!state.empty() && config_["format-" + state].isString()) {
     format = config_["format-" + state].asString();
@@ -37,21 +51,42 @@ auto waybar::modules::Cpu::update() -> void {
   } else {
     event_box_.show();
     auto icons = std::vector<std::string>{state};
-    fmt::dynamic_format_arg_store<fmt::format_context> store;
-    store.push_back(fmt::arg("load", cpu_load));
-    store.push_back(fmt::arg("usage", total_usage));
-    store.push_back(fmt::arg("icon", getIcon(total_usage, icons)));
-    store.push_back(fmt::arg("max_frequency", max_frequency));
-    store.push_back(fmt::arg("min_frequency", min_frequency));
-    store.push_back(fmt::arg("avg_frequency", avg_frequency));
-    for (size_t i = 1; i < cpu_usage.size(); ++i) {
-      auto core_i = i - 1;
-      auto core_format = fmt::format("usage{}", core_i);
-      store.push_back(fmt::arg(core_format.c_str(), cpu_usage[i]));
-      auto icon_format = fmt::format("icon{}", core_i);
-      store.push_back(fmt::arg(icon_format.c_str(), getIcon(cpu_usage[i], icons)));
-    }
-    label_.set_markup(fmt::vformat(format, store));
+    std::optional<std::tuple<float, float, float>> frequency;
+    // Index of the core in the placeholders "usage<n>" and "icon<n>", if there is such a core
+    auto core = [&cpu_usage](std::string_view name, std::string_view prefix) -> const uint16_t* {
+      if (name.substr(0, prefix.size()) != prefix) {
+        return nullptr;
+      }
+      const auto* end = name.data() + name.size();
+      size_t i = 0;
+      auto [ptr, ec] = std::from_chars(name.data() + prefix.size(), end, i);
+      if (ec != std::errc() || ptr != end || i + 1 >= cpu_usage.size()) {
+        return nullptr;
+      }
+      return &cpu_usage[i + 1];
+    };
+    setMarkup(getTemplate(format).render([&](std::string_view name, auto& out) {
+      if (name == "usage") {
+        out.write(total_usage);
+      } else if (name == "icon") {
+        out.write(getIcon(total_usage, icons));
+      } else if (name == "load") {
+        out.write(getCpuLoad());
+      } else if (name == "usage_graph") {
+        out.write(usage_history_.sparkline(0, 100));
+      } else if (name == "max_frequency" || name == "min_frequency" ||
+                 name == "avg_frequency") {
+        if (!frequency) {
+          frequency = getCpuFrequency(sample->frequencies);
+        }
+        const auto [max, min, avg] = *frequency;
+        out.write(name == "max_frequency" ? max : name == "min_frequency" ? min : avg);
+      } else if (const auto* usage = core(name, "usage")) {
+        out.write(*usage);
+      } else if (const auto* usage = core(name, "icon")) {
+        out.write(getIcon(*usage, icons));
+      }
+    }));
   }
 
   // Call parent update
@@ -66,20 +101,21 @@ double waybar::modules::Cpu::getCpuLoad() {
   throw std::runtime_error("Can't get Cpu load");
 }
 
-std::tuple<std::vector<uint16_t>, std::string> waybar::modules::Cpu::getCpuUsage() {
-  if (prev_times_.empty()) {
-    prev_times_ = parseCpuinfo();
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
-  }
-  std::vector<std::tuple<size_t, size_t>> curr_times = parseCpuinfo();
+std::tuple<std::vector<uint16_t>, std::string> waybar::modules::Cpu::getCpuUsage(
+    const CpuTimes& prev, const CpuTimes& curr) {
+  // A cpu went on- or offline, start over from the current sample
+  const auto& base = prev.idle.size() == curr.idle.size() ? prev : curr;
   std::string tooltip;
   std::vector<uint16_t> usage;
-  for (size_t i = 0; i < curr_times.size(); ++i) {
-    auto [curr_idle, curr_total] = curr_times[i];
-    auto [prev_idle, prev_total] = prev_times_[i];
-    const float delta_idle = curr_idle - prev_idle;
-    const float delta_total = curr_total - prev_total;
-    uint16_t tmp = 100 * (1 - delta_idle / delta_total);
+  for (size_t i = 0; i < curr.idle.size(); ++i) {
+    float delta_idle = curr.idle[i] - base.idle[i];
+    float delta_total = curr.total[i] - base.total[i];
+    if (delta_total < kMinDeltaJiffies) {
+      // Too close to the baseline, e.g. on the first update, use the average since boot
+      delta_idle = curr.idle[i];
+      delta_total = curr.total[i];
+    }
+    uint16_t tmp = delta_total > 0 ? 100 * (1 - delta_idle / delta_total) : 0;
     if (i == 0) {
       tooltip = fmt::format("Total: {}%", tmp);
     } else {
@@ -87,12 +123,11 @@ std::tuple<std::vector<uint16_t>, std::string> waybar::modules::Cpu::getCpuUsage
     }
     usage.push_back(tmp);
   }
-  prev_times_ = curr_times;
   return {usage, tooltip};
 }
 
-std::tuple<float, float, float> waybar::modules::Cpu::getCpuFrequency() {
-  std::vector<float> frequencies = parseCpuFrequencies();
+std::tuple<float, float, float> waybar::modules::Cpu::getCpuFrequency(
+    const std::vector<float>& frequencies) {
   if (frequencies.empty()) {
     return {0.f, 0.f, 0.f};
   }
@@ -107,3 +142,10 @@ std::tuple<float, float, float> waybar::modules::Cpu::getCpuFrequency() {
 
   return {max_frequency, min_frequency, avg_frequency};
 }
+
+void waybar::modules::Cpu::Reader::read(Sample& sample) {
+  parseCpuinfo(sample.times);
+  if (frequencies_) {
+    parseCpuFrequencies(sample.frequencies, sample.times.idle.size());
+  }
+}
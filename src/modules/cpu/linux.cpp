@@ -1,75 +1,74 @@
+#include <spdlog/spdlog.h>
+
 #include <filesystem>
 
 #include "modules/cpu.hpp"
 
-std::vector<std::tuple<size_t, size_t>> waybar::modules::Cpu::parseCpuinfo() {
-  const std::string data_dir_ = "/proc/stat";
-  std::ifstream info(data_dir_);
-  if (!info.is_open()) {
-    throw std::runtime_error("Can't open " + data_dir_);
+void waybar::modules::Cpu::Reader::parseCpuinfo(CpuTimes& times) {
+  util::parseProcStat(proc_stat_.read(), times);
+}
+
+// Leading integer part of a decimal number, e.g. the "2400" of "2400.000"
+static uint64_t parseUint(std::string_view str) {
+  uint64_t value = 0;
+  for (char c : str) {
+    if (c < '0' || c > '9') break;
+    value = value * 10 + (c - '0');
   }
-  std::vector<std::tuple<size_t, size_t>> cpuinfo;
-  std::string line;
-  while (getline(info, line)) {
-    if (line.substr(0, 3).compare("cpu") != 0) {
-      break;
-    }
-    std::stringstream sline(line.substr(5));
-    std::vector<size_t> times;
-    for (size_t time = 0; sline >> time; times.push_back(time))
-      ;
+  return value;
+}
 
-    size_t idle_time = 0;
-    size_t total_time = 0;
-    if (times.size() >= 4) {
-      idle_time = times[3];
-      total_time = std::accumulate(times.begin(), times.end(), 0);
+void waybar::modules::Cpu::Reader::discoverCpufreqFiles(size_t cpus) {
+  cpufreq_files_.clear();
+  const std::filesystem::path cpu_dir = "/sys/devices/system/cpu";
+  std::error_code ec;
+  for (const auto& entry : std::filesystem::directory_iterator(cpu_dir, ec)) {
+    const auto name = entry.path().filename().string();
+    if (name.size() <= 3 || name.compare(0, 3, "cpu") != 0 ||
+        name.find_first_not_of("0123456789", 3) != std::string::npos) {
+      continue;
+    }
+    auto path = entry.path() / "cpufreq" / "scaling_cur_freq";
+    if (std::filesystem::exists(path, ec)) {
+      cpufreq_files_.emplace_back(path.string());
     }
-    cpuinfo.emplace_back(idle_time, total_time);
   }
-  return cpuinfo;
+  cpufreq_cpus_ = cpus;
 }
 
-std::vector<float> waybar::modules::Cpu::parseCpuFrequencies() {
-  const std::string file_path_ = "/proc/cpuinfo";
-  std::ifstream info(file_path_);
-  if (!info.is_open()) {
-    throw std::runtime_error("Can't open " + file_path_);
+void waybar::modules::Cpu::Reader::parseCpuFrequencies(std::vector<float>& frequencies,
+                                                       size_t cpus) {
+  frequencies.clear();
+
+  // /proc/stat only lists online cpus, so a changed count means a cpu was hotplugged
+  if (cpufreq_cpus_ != cpus) {
+    discoverCpufreqFiles(cpus);
   }
-  std::vector<float> frequencies;
-  std::string line;
-  while (getline(info, line)) {
-    if (line.substr(0, 7).compare("cpu MHz") != 0) {
-      continue;
+  for (auto& file : cpufreq_files_) {
+    try {
+      // kHz
+      frequencies.push_back(parseUint(file.read()) / 1000.0);
+    } catch (const std::exception& e) {
+      spdlog::debug("cpu: {}", e.what());
     }
-
-    std::string frequency_str = line.substr(line.find(":") + 2);
-    float frequency = std::strtol(frequency_str.c_str(), nullptr, 10);
-    frequencies.push_back(frequency);
   }
-  info.close();
+  if (!frequencies.empty()) {
+    return;
+  }
 
-  if (frequencies.size() <= 0) {
-    std::string cpufreq_dir = "/sys/devices/system/cpu/cpufreq";
-    if (std::filesystem::exists(cpufreq_dir)) {
-      std::vector<std::string> frequency_files = {"/cpuinfo_min_freq", "/cpuinfo_max_freq"};
-      for (auto& p : std::filesystem::directory_iterator(cpufreq_dir)) {
-        for (auto freq_file : frequency_files) {
-          std::string freq_file_path = p.path().string() + freq_file;
-          if (std::filesystem::exists(freq_file_path)) {
-            std::string freq_value;
-            std::ifstream freq(freq_file_path);
-            if (freq.is_open()) {
-              getline(freq, freq_value);
-              float frequency = std::strtol(freq_value.c_str(), nullptr, 10);
-              frequencies.push_back(frequency / 1000);
-              freq.close();
-            }
-          }
-        }
+  // No cpufreq driver (e.g. in a VM), the "cpu MHz" lines of /proc/cpuinfo are all we have
+  const auto data = proc_cpuinfo_.read();
+  const std::string_view key = "cpu MHz";
+  for (size_t pos = 0; pos < data.size();) {
+    auto eol = data.find('\n', pos);
+    if (eol == std::string_view::npos) eol = data.size();
+    const auto line = data.substr(pos, eol - pos);
+    if (line.substr(0, key.size()) == key) {
+      if (auto value = line.find_first_not_of(" \t:", key.size());
+          value != std::string_view::npos) {
+        frequencies.push_back(parseUint(line.substr(value)));
       }
     }
+    pos = eol + 1;
   }
-
-  return frequencies;
 }
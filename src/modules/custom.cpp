@@ -1,128 +1,159 @@
 #include "modules/custom.hpp"
 
 #include <spdlog/spdlog.h>
+#include <sys/stat.h>
+
+#include <algorithm>
 
 waybar::modules::Custom::Custom(const std::string& name, const std::string& id,
                                 const Json::Value& config)
-    : ALabel(config, "custom-" + name, id, "{}"),
-      name_(name),
-      id_(id),
-      percentage_(0),
-      fp_(nullptr),
-      pid_(-1) {
+    : ALabel(config, "custom-" + name, id, "{}"), name_(name), id_(id), percentage_(0) {
+  if (config_["exec-timeout"].isNumeric()) {
+    limits_.timeout =
+        std::chrono::milliseconds(static_cast<int64_t>(config_["exec-timeout"].asDouble() * 1000));
+  }
+  if (config_["exec-if-interval"].isNumeric()) {
+    exec_if_ttl_ = std::chrono::milliseconds(
+        static_cast<int64_t>(config_["exec-if-interval"].asDouble() * 1000));
+  }
   dp.emit();
+  rerun_.connect([this] { timer_.wake_up(); });
   if (!config_["signal"].empty() && config_["interval"].empty()) {
-    waitingWorker();
+    // A zero interval runs once, and then only when woken up
+    timer_ = util::Scheduler::inst().every(std::chrono::seconds::zero(), [this] { startExec(); });
   } else if (interval_.count() > 0) {
-    delayWorker();
+    timer_ = util::Scheduler::inst().every(interval_, [this] { startExec(); });
   } else if (config_["exec"].isString()) {
-    continuousWorker();
+    if (config_["restart-interval"].isUInt()) {
+      // Restarts the script on the next tick after it exited
+      timer_ = util::Scheduler::inst().every(
+          std::chrono::seconds(config_["restart-interval"].asUInt()), [this] { startStream(); });
+    } else {
+      startStream();
+      if (!process_) {
+        throw std::runtime_error("Unable to open " + config_["exec"].asString());
+      }
+    }
   }
 }
 
 waybar::modules::Custom::~Custom() {
-  if (pid_ != -1) {
-    killpg(pid_, SIGTERM);
-    waitpid(pid_, NULL, 0);
-    pid_ = -1;
-  }
+  // Nothing may start a new process once the current one is cancelled
+  timer_.cancel();
+  process_.cancel();
 }
 
-void waybar::modules::Custom::delayWorker() {
-  thread_ = [this] {
-    bool can_update = true;
-    if (config_["exec-if"].isString()) {
-      output_ = util::command::execNoRead(config_["exec-if"].asString());
-      if (output_.exit_code != 0) {
-        can_update = false;
-        dp.emit();
-      }
-    }
-    if (can_update) {
-      if (config_["exec"].isString()) {
-        output_ = util::command::exec(config_["exec"].asString());
-      }
+void waybar::modules::Custom::startExec() {
+  if (!config_["exec"].isString() && !config_["exec-if"].isString()) {
+    dp.emit();
+    return;
+  }
+  // Still running since the last tick
+  if (busy_.exchange(true)) {
+    return;
+  }
+  if (forced_.exchange(false)) {
+    exec_if_expiry_ = {};
+    exec_key_.reset();
+  }
+
+  std::vector<util::Reactor::Step> steps;
+  if (config_["exec-if"].isString()) {
+    if (std::chrono::steady_clock::now() >= exec_if_expiry_) {
+      steps.push_back({config_["exec-if"].asString(), [this](const util::command::res& result) {
+                         exec_if_result_ = result.exit_code;
+                         exec_if_expiry_ = std::chrono::steady_clock::now() + exec_if_ttl_;
+                         if (result.exit_code != 0) {
+                           exec_key_.reset();
+                         }
+                         return result.exit_code == 0;
+                       }});
+    } else if (exec_if_result_ != 0) {
+      output_ = {exec_if_result_, ""};
+      busy_ = false;
       dp.emit();
+      return;
     }
-    thread_.sleep_for(interval_);
-  };
-}
+  }
+  key_unchanged_ = false;
+  if (config_["exec-key"].isString()) {
+    steps.push_back({config_["exec-key"].asString(), [this](const util::command::res& result) {
+                       // Without a key, run exec every time
+                       return checkKey(result.exit_code == 0 ? std::optional(result.out)
+                                                             : std::nullopt);
+                     }});
+  } else if (config_["exec-key-file"].isString()) {
+    steps.push_back({"", [this](const util::command::res&) { return checkKey(fileKey()); }});
+  }
+  if (config_["exec"].isString()) {
+    steps.push_back({config_["exec"].asString(), nullptr});
+  }
 
-void waybar::modules::Custom::continuousWorker() {
-  auto cmd = config_["exec"].asString();
-  pid_ = -1;
-  fp_ = util::command::open(cmd, pid_);
-  if (!fp_) {
-    throw std::runtime_error("Unable to open " + cmd);
-  }
-  thread_ = [this, cmd] {
-    char* buff = nullptr;
-    size_t len = 0;
-    if (getline(&buff, &len, fp_) == -1) {
-      int exit_code = 1;
-      if (fp_) {
-        exit_code = WEXITSTATUS(util::command::close(fp_, pid_));
-        fp_ = nullptr;
-      }
-      if (exit_code != 0) {
-        output_ = {exit_code, ""};
-        dp.emit();
-        spdlog::error("{} stopped unexpectedly, is it endless?", name_);
-      }
-      if (config_["restart-interval"].isUInt()) {
-        pid_ = -1;
-        thread_.sleep_for(std::chrono::seconds(config_["restart-interval"].asUInt()));
-        fp_ = util::command::open(cmd, pid_);
-        if (!fp_) {
-          throw std::runtime_error("Unable to open " + cmd);
+  process_ = util::Reactor::inst().exec(
+      std::move(steps), limits_, [this](util::command::res result) {
+        // The output of the last run of exec is still valid
+        if (!key_unchanged_) {
+          if (result.exit_code != 0) {
+            // Try again on the next tick
+            exec_key_.reset();
+            result.out.clear();
+          }
+          output_ = std::move(result);
+          dp.emit();
         }
-      } else {
-        thread_.stop();
-        return;
-      }
-    } else {
-      std::string output = buff;
+        busy_ = false;
+        // A signal or click came in while running, it wants a run of its own
+        if (forced_) {
+          rerun_.emit();
+        }
+      });
+}
 
-      // Remove last newline
-      if (!output.empty() && output[output.length() - 1] == '\n') {
-        output.erase(output.length() - 1);
-      }
-      output_ = {0, output};
-      dp.emit();
-    }
-    free(buff);
-  };
+bool waybar::modules::Custom::checkKey(std::optional<std::string> key) {
+  key_unchanged_ = key && key == exec_key_;
+  exec_key_ = std::move(key);
+  return !key_unchanged_;
+}
+
+std::optional<std::string> waybar::modules::Custom::fileKey() const {
+  struct stat st;
+  if (stat(config_["exec-key-file"].asCString(), &st) != 0) {
+    return std::nullopt;
+  }
+  return fmt::format("{}.{}:{}", st.st_mtim.tv_sec, st.st_mtim.tv_nsec, st.st_size);
 }
 
-void waybar::modules::Custom::waitingWorker() {
-  thread_ = [this] {
-    bool can_update = true;
-    if (config_["exec-if"].isString()) {
-      output_ = util::command::execNoRead(config_["exec-if"].asString());
-      if (output_.exit_code != 0) {
-        can_update = false;
+void waybar::modules::Custom::startStream() {
+  if (busy_.exchange(true)) {
+    return;
+  }
+  process_ = util::Reactor::inst().stream(
+      config_["exec"].asString(),
+      [this](std::string_view line) {
+        output_ = {0, std::string(line)};
         dp.emit();
-      }
-    }
-    if (can_update) {
-      if (config_["exec"].isString()) {
-        output_ = util::command::exec(config_["exec"].asString());
-      }
-      dp.emit();
-    }
-    thread_.sleep();
-  };
+      },
+      [this](util::command::res result) {
+        if (result.exit_code != 0) {
+          output_ = std::move(result);
+          dp.emit();
+          spdlog::error("{} stopped unexpectedly, is it endless?", name_);
+        }
+        busy_ = false;
+      });
 }
 
 void waybar::modules::Custom::refresh(int sig) {
   if (sig == SIGRTMIN + config_["signal"].asInt()) {
-    thread_.wake_up();
+    forced_ = true;
+    timer_.wake_up();
   }
 }
 
 void waybar::modules::Custom::handleEvent() {
   if (!config_["exec-on-event"].isBool() || config_["exec-on-event"].asBool()) {
-    thread_.wake_up();
+    forced_ = true;
+    timer_.wake_up();
   }
 }
 
@@ -138,6 +169,11 @@ bool waybar::modules::Custom::handleToggle(GdkEventButton* const& e) {
   return ret;
 }
 
+void waybar::modules::Custom::handleCommandExit(const std::string& event, int exit_code) {
+  ALabel::handleCommandExit(event, exit_code);
+  setClass("command-failed", exit_code != 0);
+}
+
 auto waybar::modules::Custom::update() -> void {
   // Hide label if output is empty
   if ((config_["exec"].isString() || config_["exec-if"].isString()) &&
@@ -155,28 +191,22 @@ auto waybar::modules::Custom::update() -> void {
     if (str.empty()) {
       event_box_.hide();
     } else {
-      label_.set_markup(str);
+      setMarkup(str);
       if (tooltipEnabled()) {
-        if (text_ == tooltip_) {
-          if (label_.get_tooltip_markup() != str) {
-            label_.set_tooltip_markup(str);
-          }
-        } else {
-          if (label_.get_tooltip_markup() != tooltip_) {
-            label_.set_tooltip_markup(tooltip_);
-          }
-        }
+        setTooltipMarkup(text_ == tooltip_ ? str : tooltip_);
       }
-      auto classes = label_.get_style_context()->list_classes();
-      for (auto const& c : classes) {
-        if (c == id_) continue;
-        label_.get_style_context()->remove_class(c);
+      // Only touch the classes that changed since the last output
+      for (auto const& c : applied_class_) {
+        if (std::find(class_.begin(), class_.end(), c) == class_.end()) {
+          setClass(c, false);
+        }
       }
       for (auto const& c : class_) {
-        label_.get_style_context()->add_class(c);
+        setClass(c, true);
       }
-      label_.get_style_context()->add_class("flat");
-      label_.get_style_context()->add_class("text-button");
+      applied_class_ = class_;
+      setClass("flat", true);
+      setClass("text-button", true);
       event_box_.show();
     }
   }
@@ -4,16 +4,27 @@ using namespace waybar::util;
 
 waybar::modules::Disk::Disk(const std::string& id, const Json::Value& config)
     : ALabel(config, "disk", id, "{}%", 30), path_("/") {
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
   if (config["path"].isString()) {
     path_ = config["path"].asString();
   }
   if (config["unit"].isString()) {
     unit_ = config["unit"].asString();
   }
+  // statvfs blocks for as long as a network filesystem doesn't answer
+  auto sampler = util::Sampler<Stats>::get(
+      "disk:" + path_,
+      [this] {
+        return [path = path_](Stats& stats) {
+          struct statvfs buf;
+          if (statvfs(path.c_str(), &buf) == 0) {
+            stats = buf;
+          } else {
+            stats.reset();
+          }
+        };
+      },
+      true);
+  sampler_ = sampler->subscribe(interval_, [this] { dp.emit(); });
 }
 
 auto waybar::modules::Disk::update() -> void {
@@ -31,7 +42,7 @@ auto waybar::modules::Disk::update() -> void {
       unsigned long  f_namemax;  // maximum filename length
   }; */
       stats;
-  int err = statvfs(path_.c_str(), &stats);
+  const auto snapshot = sampler_.latest();
 
   /* Conky options
     fs_bar - Bar that shows how much space is used
@@ -41,10 +52,11 @@ auto waybar::modules::Disk::update() -> void {
     fs_used - File system used space
   */
 
-  if (err != 0) {
+  if (!snapshot->has_value()) {
     event_box_.hide();
     return;
   }
+  stats = **snapshot;
 
   float specific_free, specific_used, specific_total, divisor;
 
@@ -64,16 +76,34 @@ auto waybar::modules::Disk::update() -> void {
     format = config_["format-" + state].asString();
   }
 
+  auto percentage_free = stats.f_bavail * 100 / stats.f_blocks;
+  auto lookup = [&](std::string_view name, util::FormatTemplate::Writer& out) {
+    if (name == "percentage_free" || name == "0") {
+      out.write(percentage_free);
+    } else if (name == "percentage_used") {
+      out.write(percentage_used);
+    } else if (name == "free") {
+      out.write(free);
+    } else if (name == "used") {
+      out.write(used);
+    } else if (name == "total") {
+      out.write(total);
+    } else if (name == "path") {
+      out.write(path_);
+    } else if (name == "specific_free") {
+      out.write(specific_free);
+    } else if (name == "specific_used") {
+      out.write(specific_used);
+    } else if (name == "specific_total") {
+      out.write(specific_total);
+    }
+  };
+
   if (format.empty()) {
     event_box_.hide();
   } else {
     event_box_.show();
-    label_.set_markup(fmt::format(
-        fmt::runtime(format), stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
-        fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks), fmt::arg("used", used),
-        fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
-        fmt::arg("path", path_), fmt::arg("specific_free", specific_free), 
-        fmt::arg("specific_used", specific_used), fmt::arg("specific_total", specific_total)));
+    setMarkup(getTemplate(format).render(lookup));
   }
 
   if (tooltipEnabled()) {
@@ -81,12 +111,7 @@ auto waybar::modules::Disk::update() -> void {
     if (config_["tooltip-format"].isString()) {
       tooltip_format = config_["tooltip-format"].asString();
     }
-    label_.set_tooltip_text(fmt::format(
-        fmt::runtime(tooltip_format), stats.f_bavail * 100 / stats.f_blocks, fmt::arg("free", free),
-        fmt::arg("percentage_free", stats.f_bavail * 100 / stats.f_blocks), fmt::arg("used", used),
-        fmt::arg("percentage_used", percentage_used), fmt::arg("total", total),
-        fmt::arg("path", path_), fmt::arg("specific_free", specific_free), 
-        fmt::arg("specific_used", specific_used), fmt::arg("specific_total", specific_total)));
+    setTooltipText(getTemplate(tooltip_format).render(lookup));
   }
   // Call parent update
   ALabel::update();
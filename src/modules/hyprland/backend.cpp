@@ -1,8 +1,6 @@
 #include "modules/hyprland/backend.hpp"
 
 #include <ctype.h>
-#include <netdb.h>
-#include <netinet/in.h>
 #include <spdlog/spdlog.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -13,12 +11,25 @@
 #include <sys/un.h>
 #include <unistd.h>
 
-#include <fstream>
-#include <iostream>
+#include <algorithm>
 #include <string>
 
+#include "modules/hyprland/state.hpp"
+
 namespace waybar::modules::hyprland {
 
+IPC::IPC() {
+  // get the instance signature
+  if (auto instanceSig = getenv("HYPRLAND_INSTANCE_SIGNATURE")) {
+    socket1Path_ = "/tmp/hypr/" + std::string(instanceSig) + "/.socket.sock";
+  }
+
+  // registered first, so the state is up to date when modules receive an event
+  state_ = std::make_unique<State>(*this);
+
+  startIPC();
+}
+
 void IPC::startIPC() {
   // will start IPC and relay events to parseIPC
 
@@ -35,68 +46,116 @@ void IPC::startIPC() {
 
     spdlog::info("Hyprland IPC starting");
 
-    struct sockaddr_un addr;
-    int socketfd = socket(AF_UNIX, SOCK_STREAM, 0);
-
-    if (socketfd == -1) {
-      spdlog::error("Hyprland IPC: socketfd failed");
-      return;
-    }
-
-    addr.sun_family = AF_UNIX;
-
     // socket path
-    std::string socketPath = "/tmp/hypr/" + std::string(HIS) + "/.socket2.sock";
+    const std::string socketPath = "/tmp/hypr/" + std::string(HIS) + "/.socket2.sock";
 
-    strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
+    // Hyprland socket2 events are max 1024 bytes, a single read usually returns a whole burst
+    std::vector<char> buffer(65536);
+    auto backoff = kReconnectMin;
 
-    addr.sun_path[sizeof(addr.sun_path) - 1] = 0;
+    while (true) {
+      int socketfd = connectSocket2(socketPath);
 
-    int l = sizeof(struct sockaddr_un);
+      if (socketfd == -1) {
+        spdlog::debug("Hyprland IPC: Unable to connect, retrying in {}ms", backoff.count());
+        std::this_thread::sleep_for(backoff);
+        backoff = std::min(backoff * 2, kReconnectMax);
+        continue;
+      }
+      backoff = kReconnectMin;
+
+      size_t used = 0;
+      while (true) {
+        if (used == buffer.size()) {
+          spdlog::warn("Hyprland IPC: Dropping an event larger than {} bytes", buffer.size());
+          used = 0;
+        }
+
+        auto received = read(socketfd, buffer.data() + used, buffer.size() - used);
+
+        if (received < 0 && errno == EINTR) {
+          continue;
+        }
+        if (received <= 0) {
+          break;
+        }
+        used += received;
+
+        // dispatch every complete event of the burst under a single lock
+        size_t start = 0;
+        {
+          std::lock_guard<std::mutex> lock(callbackMutex);
+          while (auto* newline = static_cast<char*>(
+                     memchr(buffer.data() + start, '\n', used - start))) {
+            const size_t end = newline - buffer.data();
+            std::string messageReceived(buffer.data() + start, end - start);
+            start = end + 1;
+
+            spdlog::debug("hyprland IPC received {}", messageReceived);
+
+            parseIPC(messageReceived);
+          }
+        }
+
+        // keep the incomplete tail for the next read
+        memmove(buffer.data(), buffer.data() + start, used - start);
+        used -= start;
+      }
 
-    if (connect(socketfd, (struct sockaddr*)&addr, l) == -1) {
-      spdlog::error("Hyprland IPC: Unable to connect?");
-      return;
+      close(socketfd);
+      spdlog::warn("Hyprland IPC: Connection to socket2 lost, reconnecting");
+      // events might have been missed in the meantime
+      state_->invalidate();
     }
+  }).detach();
+}
 
-    auto file = fdopen(socketfd, "r");
-
-    while (1) {
-      // read
-
-      char buffer[1024];  // Hyprland socket2 events are max 1024 bytes
-      auto recievedCharPtr = fgets(buffer, 1024, file);
+int IPC::connectSocket2(const std::string& socketPath) {
+  struct sockaddr_un addr = {0};
+  int socketfd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
 
-      if (!recievedCharPtr) {
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        continue;
-      }
+  if (socketfd == -1) {
+    spdlog::error("Hyprland IPC: socketfd failed");
+    return -1;
+  }
 
-      callbackMutex.lock();
+  addr.sun_family = AF_UNIX;
 
-      std::string messageRecieved(buffer);
+  strncpy(addr.sun_path, socketPath.c_str(), sizeof(addr.sun_path) - 1);
 
-      messageRecieved = messageRecieved.substr(0, messageRecieved.find_first_of('\n'));
+  addr.sun_path[sizeof(addr.sun_path) - 1] = 0;
 
-      spdlog::debug("hyprland IPC received {}", messageRecieved);
+  int l = sizeof(struct sockaddr_un);
 
-      parseIPC(messageRecieved);
+  if (connect(socketfd, (struct sockaddr*)&addr, l) == -1) {
+    close(socketfd);
+    return -1;
+  }
 
-      callbackMutex.unlock();
+  return socketfd;
+}
 
-      std::this_thread::sleep_for(std::chrono::milliseconds(1));
-    }
-  }).detach();
+IPC::~IPC() {
+  {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    asyncRunning_ = false;
+  }
+  asyncCv_.notify_all();
+  if (asyncThread_.joinable()) {
+    asyncThread_.join();
+  }
 }
 
 void IPC::parseIPC(const std::string& ev) {
-  // todo
   std::string request = ev.substr(0, ev.find_first_of('>'));
 
-  for (auto& [eventname, handler] : callbacks) {
-    if (eventname == request) {
-      handler->onEvent(ev);
-    }
+  auto it = callbacks.find(request);
+  if (it == callbacks.end()) {
+    return;
+  }
+
+  for (auto* handler : it->second) {
+    handler->onEvent(ev);
   }
 }
 
@@ -106,7 +165,7 @@ void IPC::registerForIPC(const std::string& ev, EventHandler* ev_handler) {
   }
   callbackMutex.lock();
 
-  callbacks.emplace_back(std::make_pair(ev, ev_handler));
+  callbacks[ev].push_back(ev_handler);
 
   callbackMutex.unlock();
 }
@@ -118,13 +177,8 @@ void IPC::unregisterForIPC(EventHandler* ev_handler) {
 
   callbackMutex.lock();
 
-  for (auto it = callbacks.begin(); it != callbacks.end();) {
-    auto it_current = it;
-    it++;
-    auto& [eventname, handler] = *it_current;
-    if (handler == ev_handler) {
-      callbacks.erase(it_current);
-    }
+  for (auto& [eventname, handlers] : callbacks) {
+    handlers.erase(std::remove(handlers.begin(), handlers.end(), ev_handler), handlers.end());
   }
 
   callbackMutex.unlock();
@@ -132,50 +186,35 @@ void IPC::unregisterForIPC(EventHandler* ev_handler) {
 
 std::string IPC::getSocket1Reply(const std::string& rq) {
   // basically hyprctl
+  // Hyprland closes the request socket after every reply, so there is no connection to keep
+  // around. Several requests can still share a round-trip, see getSocket1JsonReplies.
 
-  struct addrinfo ai_hints;
-  struct addrinfo* ai_res = NULL;
-  const auto SERVERSOCKET = socket(AF_UNIX, SOCK_STREAM, 0);
-
-  if (SERVERSOCKET < 0) {
-    spdlog::error("Hyprland IPC: Couldn't open a socket (1)");
-    return "";
-  }
-
-  memset(&ai_hints, 0, sizeof(struct addrinfo));
-  ai_hints.ai_family = AF_UNSPEC;
-  ai_hints.ai_socktype = SOCK_STREAM;
-
-  if (getaddrinfo("localhost", NULL, &ai_hints, &ai_res) != 0) {
-    spdlog::error("Hyprland IPC: Couldn't get host (2)");
-    return "";
-  }
-
-  // get the instance signature
-  auto instanceSig = getenv("HYPRLAND_INSTANCE_SIGNATURE");
-
-  if (!instanceSig) {
+  if (socket1Path_.empty()) {
     spdlog::error("Hyprland IPC: HYPRLAND_INSTANCE_SIGNATURE was not set! (Is Hyprland running?)");
     return "";
   }
 
-  std::string instanceSigStr = std::string(instanceSig);
-
   sockaddr_un serverAddress = {0};
   serverAddress.sun_family = AF_UNIX;
 
-  std::string socketPath = "/tmp/hypr/" + instanceSigStr + "/.socket.sock";
-
   // Use snprintf to copy the socketPath string into serverAddress.sun_path
-  if (snprintf(serverAddress.sun_path, sizeof(serverAddress.sun_path), "%s", socketPath.c_str()) <
-      0) {
+  if (snprintf(serverAddress.sun_path, sizeof(serverAddress.sun_path), "%s",
+               socket1Path_.c_str()) < 0) {
     spdlog::error("Hyprland IPC: Couldn't copy socket path (6)");
     return "";
   }
 
+  const auto SERVERSOCKET = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+  if (SERVERSOCKET < 0) {
+    spdlog::error("Hyprland IPC: Couldn't open a socket (1)");
+    return "";
+  }
+
   if (connect(SERVERSOCKET, reinterpret_cast<sockaddr*>(&serverAddress), sizeof(serverAddress)) <
       0) {
-    spdlog::error("Hyprland IPC: Couldn't connect to " + socketPath + ". (3)");
+    spdlog::error("Hyprland IPC: Couldn't connect to " + socket1Path_ + ". (3)");
+    close(SERVERSOCKET);
     return "";
   }
 
@@ -183,23 +222,33 @@ std::string IPC::getSocket1Reply(const std::string& rq) {
 
   if (sizeWritten < 0) {
     spdlog::error("Hyprland IPC: Couldn't write (4)");
+    close(SERVERSOCKET);
     return "";
   }
 
-  char buffer[8192] = {0};
+  // Read straight into the response, growing it as needed. `clients` replies are often
+  // larger than a few pages.
+  constexpr size_t chunkSize = 65536;
   std::string response;
+  size_t size = 0;
 
   do {
-    sizeWritten = read(SERVERSOCKET, buffer, 8192);
+    response.resize(size + chunkSize);
+    sizeWritten = read(SERVERSOCKET, response.data() + size, chunkSize);
 
     if (sizeWritten < 0) {
+      if (errno == EINTR) {
+        sizeWritten = 1;
+        continue;
+      }
       spdlog::error("Hyprland IPC: Couldn't read (5)");
       close(SERVERSOCKET);
       return "";
     }
-    response.append(buffer, sizeWritten);
+    size += sizeWritten;
   } while (sizeWritten > 0);
 
+  response.resize(size);
   close(SERVERSOCKET);
   return response;
 }
@@ -208,4 +257,107 @@ Json::Value IPC::getSocket1JsonReply(const std::string& rq) {
   return parser_.parse(getSocket1Reply("j/" + rq));
 }
 
+std::vector<std::string_view> IPC::splitJsonDocuments(std::string_view data) {
+  // Batched replies are concatenated, split them on the top-level objects and arrays
+  std::vector<std::string_view> documents;
+  size_t start = 0;
+  int depth = 0;
+  bool inString = false;
+  bool escaped = false;
+
+  for (size_t i = 0; i < data.size(); i++) {
+    const char c = data[i];
+    if (inString) {
+      if (escaped) {
+        escaped = false;
+      } else if (c == '\\') {
+        escaped = true;
+      } else if (c == '"') {
+        inString = false;
+      }
+      continue;
+    }
+    switch (c) {
+      case '"':
+        inString = depth > 0;
+        break;
+      case '{':
+      case '[':
+        if (depth++ == 0) start = i;
+        break;
+      case '}':
+      case ']':
+        if (depth > 0 && --depth == 0) documents.push_back(data.substr(start, i - start + 1));
+        break;
+      default:
+        break;
+    }
+  }
+  return documents;
+}
+
+std::vector<Json::Value> IPC::getSocket1JsonReplies(const std::vector<std::string>& rqs) {
+  std::string batch = "[[BATCH]]";
+  for (const auto& rq : rqs) {
+    batch += "j/" + rq + ";";
+  }
+
+  const auto reply = getSocket1Reply(batch);
+  const auto documents = splitJsonDocuments(reply);
+
+  std::vector<Json::Value> replies;
+  if (documents.size() == rqs.size()) {
+    try {
+      for (const auto& document : documents) {
+        replies.push_back(parser_.parse(std::string(document)));
+      }
+      return replies;
+    } catch (const std::exception& e) {
+      spdlog::warn("Hyprland IPC: Failed to parse batched reply: {}", e.what());
+    }
+  } else {
+    spdlog::debug("Hyprland IPC: Batched reply has {} documents, expected {}", documents.size(),
+                  rqs.size());
+  }
+
+  // fall back to one request at a time
+  replies.clear();
+  for (const auto& rq : rqs) {
+    replies.push_back(getSocket1JsonReply(rq));
+  }
+  return replies;
+}
+
+void IPC::getSocket1ReplyAsync(const std::string& rq,
+                               std::function<void(const std::string&)> callback) {
+  {
+    std::lock_guard<std::mutex> lock(asyncMutex_);
+    asyncQueue_.emplace_back(rq, std::move(callback));
+    if (!asyncThread_.joinable()) {
+      asyncThread_ = std::thread([this] { asyncWorker(); });
+    }
+  }
+  asyncCv_.notify_one();
+}
+
+void IPC::asyncWorker() {
+  std::unique_lock<std::mutex> lock(asyncMutex_);
+  while (true) {
+    asyncCv_.wait(lock, [this] { return !asyncRunning_ || !asyncQueue_.empty(); });
+    if (!asyncRunning_) {
+      return;
+    }
+    auto [rq, callback] = std::move(asyncQueue_.front());
+    asyncQueue_.pop_front();
+    lock.unlock();
+
+    auto reply = getSocket1Reply(rq);
+    if (callback) {
+      callback(reply);
+    }
+
+    lock.lock();
+  }
+}
+
 }  // namespace waybar::modules::hyprland
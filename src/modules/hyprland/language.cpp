@@ -52,7 +52,7 @@ auto Language::update() -> void {
 
   if (!format_.empty()) {
     label_.show();
-    label_.set_markup(layoutName);
+    setMarkup(layoutName);
   } else {
     label_.hide();
   }
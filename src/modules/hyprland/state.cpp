@@ -0,0 +1,351 @@
+#include "modules/hyprland/state.hpp"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+namespace waybar::modules::hyprland {
+
+State::State(IPC& ipc) : ipc_(ipc) {
+  for (const auto* ev :
+       {"workspace", "focusedmon", "createworkspace", "destroyworkspace", "moveworkspace",
+        "renameworkspace", "openwindow", "closewindow", "movewindow", "activewindow",
+        "activewindowv2", "changefloatingmode", "fullscreen", "monitoradded", "monitorremoved"}) {
+    ipc_.registerForIPC(ev, this);
+  }
+}
+
+State::~State() { ipc_.unregisterForIPC(this); }
+
+void State::invalidate() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  stale_ = true;
+}
+
+void State::reconcileIfNeeded() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  // Another reader is already fetching, its result will do
+  fetched_.wait(lock, [this] { return !fetching_; });
+  std::vector<std::string> requests;
+  const auto now = std::chrono::steady_clock::now();
+  if (stale_ || now - lastReconcile_ >= kReconcileInterval) {
+    requests = {"monitors", "workspaces", "clients"};
+  } else if (clientsStale_) {
+    requests = {"clients"};
+  } else {
+    return;
+  }
+  fetching_ = true;
+  lock.unlock();
+
+  spdlog::debug("Hyprland state: refetching {}",
+                requests.size() == 3 ? "monitors, workspaces and clients" : "clients");
+  auto replies = ipc_.getSocket1JsonReplies(requests);
+
+  std::map<std::string, Json::Value> monitors;
+  std::map<int, Json::Value> workspaces;
+  std::map<std::string, Json::Value> clients;
+  if (requests.size() == 3) {
+    for (auto& monitor : replies[0]) {
+      monitors.emplace(monitor["name"].asString(), std::move(monitor));
+    }
+    for (auto& workspace : replies[1]) {
+      workspaces.emplace(workspace["id"].asInt(), std::move(workspace));
+    }
+  }
+  for (auto& client : replies.back()) {
+    clients.emplace(client["address"].asString(), std::move(client));
+  }
+
+  lock.lock();
+  if (requests.size() == 3) {
+    monitors_.swap(monitors);
+    workspaces_.swap(workspaces);
+    stale_ = false;
+    lastReconcile_ = now;
+  }
+  clients_.swap(clients);
+  clientsStale_ = false;
+  fetching_ = false;
+  for (const auto& [eventName, payload] : pending_) {
+    apply(eventName, payload);
+  }
+  pending_.clear();
+  fetched_.notify_all();
+}
+
+Json::Value State::monitors() {
+  reconcileIfNeeded();
+  std::lock_guard<std::mutex> lock(mutex_);
+  Json::Value result(Json::arrayValue);
+  for (const auto& [name, monitor] : monitors_) {
+    result.append(monitor);
+  }
+  return result;
+}
+
+Json::Value State::workspaces() {
+  reconcileIfNeeded();
+  std::lock_guard<std::mutex> lock(mutex_);
+  Json::Value result(Json::arrayValue);
+  for (const auto& [id, workspace] : workspaces_) {
+    result.append(workspace);
+  }
+  return result;
+}
+
+Json::Value State::clients() {
+  reconcileIfNeeded();
+  std::lock_guard<std::mutex> lock(mutex_);
+  Json::Value result(Json::arrayValue);
+  for (const auto& [address, client] : clients_) {
+    result.append(client);
+  }
+  return result;
+}
+
+Json::Value State::activeWorkspace() {
+  reconcileIfNeeded();
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (auto* monitor = focusedMonitor()) {
+    auto it = workspaces_.find((*monitor)["activeWorkspace"]["id"].asInt());
+    if (it != workspaces_.end()) {
+      return it->second;
+    }
+  }
+  return Json::Value(Json::objectValue);
+}
+
+Json::Value* State::findWorkspace(const std::string& name) {
+  for (auto& [id, workspace] : workspaces_) {
+    if (workspace["name"].asString() == name) {
+      return &workspace;
+    }
+  }
+  return nullptr;
+}
+
+Json::Value* State::findClient(const std::string& address) {
+  // IPC events don't prefix addresses with 0x, unlike the JSON replies
+  auto it = clients_.find("0x" + address);
+  return it == clients_.end() ? nullptr : &it->second;
+}
+
+Json::Value* State::focusedMonitor() {
+  for (auto& [name, monitor] : monitors_) {
+    if (monitor["focused"].asBool()) {
+      return &monitor;
+    }
+  }
+  return nullptr;
+}
+
+void State::setActiveWorkspace(Json::Value& monitor, const std::string& name) {
+  auto* workspace = findWorkspace(name);
+  if (workspace == nullptr) {
+    stale_ = true;
+    return;
+  }
+  monitor["activeWorkspace"]["id"] = (*workspace)["id"];
+  monitor["activeWorkspace"]["name"] = name;
+  // Created workspaces are assumed on the focused monitor, workspace rules may say otherwise
+  (*workspace)["monitor"] = monitor["name"];
+  (*workspace)["monitorID"] = monitor["id"];
+}
+
+void State::addWindows(int workspaceId, int count) {
+  auto it = workspaces_.find(workspaceId);
+  if (it != workspaces_.end()) {
+    it->second["windows"] = std::max(0, it->second["windows"].asInt() + count);
+  }
+}
+
+void State::onEvent(const std::string& ev) {
+  const auto separator = ev.find(">>");
+  if (separator == std::string::npos) {
+    return;
+  }
+  std::string eventName = ev.substr(0, separator);
+  std::string payload = ev.substr(separator + 2);
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (fetching_) {
+    pending_.emplace_back(std::move(eventName), std::move(payload));
+  } else {
+    apply(eventName, payload);
+  }
+}
+
+void State::apply(const std::string& eventName, const std::string& payload) {
+  if (stale_) {
+    // the next reader refetches everything anyway
+    return;
+  }
+  const auto comma = payload.find(',');
+  const std::string first = payload.substr(0, comma);
+  const std::string rest = comma == std::string::npos ? "" : payload.substr(comma + 1);
+
+  if (eventName == "workspace") {
+    if (auto* monitor = focusedMonitor()) {
+      setActiveWorkspace(*monitor, payload);
+    } else {
+      stale_ = true;
+    }
+  } else if (eventName == "focusedmon") {
+    for (auto& [name, monitor] : monitors_) {
+      monitor["focused"] = name == first;
+    }
+    auto it = monitors_.find(first);
+    if (it == monitors_.end()) {
+      stale_ = true;
+    } else {
+      setActiveWorkspace(it->second, rest);
+    }
+  } else if (eventName == "destroyworkspace") {
+    if (auto* workspace = findWorkspace(payload)) {
+      workspaces_.erase((*workspace)["id"].asInt());
+    }
+  } else if (eventName == "renameworkspace") {
+    auto it = workspaces_.find(first == "special" ? -99 : std::atoi(first.c_str()));
+    if (it == workspaces_.end()) {
+      stale_ = true;
+    } else {
+      it->second["name"] = rest;
+      for (auto& [name, monitor] : monitors_) {
+        if (monitor["activeWorkspace"]["id"].asInt() == it->first) {
+          monitor["activeWorkspace"]["name"] = rest;
+        }
+      }
+      for (auto& [address, client] : clients_) {
+        if (client["workspace"]["id"].asInt() == it->first) {
+          client["workspace"]["name"] = rest;
+        }
+      }
+    }
+  } else if (eventName == "createworkspace") {
+    // Named and special workspaces have ids that the event doesn't tell
+    const int id = std::atoi(payload.c_str());
+    auto* monitor = focusedMonitor();
+    if (findWorkspace(payload) != nullptr) {
+      return;
+    }
+    if (id <= 0 || std::to_string(id) != payload || monitor == nullptr) {
+      stale_ = true;
+      return;
+    }
+    Json::Value workspace(Json::objectValue);
+    workspace["id"] = id;
+    workspace["name"] = payload;
+    workspace["monitor"] = (*monitor)["name"];
+    workspace["monitorID"] = (*monitor)["id"];
+    workspace["windows"] = 0;
+    workspace["hasfullscreen"] = false;
+    workspace["lastwindow"] = "0x0";
+    workspace["lastwindowtitle"] = "";
+    workspaces_.emplace(id, std::move(workspace));
+  } else if (eventName == "moveworkspace") {
+    auto* workspace = findWorkspace(first);
+    auto monitor = monitors_.find(rest);
+    if (workspace == nullptr || monitor == monitors_.end()) {
+      stale_ = true;
+      return;
+    }
+    const auto id = (*workspace)["id"].asInt();
+    for (auto& [name, other] : monitors_) {
+      if (name != rest && other["activeWorkspace"]["id"].asInt() == id) {
+        // Its old monitor switches to another workspace, which isn't always announced
+        stale_ = true;
+        return;
+      }
+    }
+    (*workspace)["monitor"] = rest;
+    (*workspace)["monitorID"] = monitor->second["id"];
+    for (auto& [address, client] : clients_) {
+      if (client["workspace"]["id"].asInt() == id) {
+        client["monitor"] = monitor->second["id"];
+      }
+    }
+  } else if (eventName == "openwindow") {
+    // ADDRESS,WORKSPACENAME,CLASS,TITLE; the title may contain commas
+    const auto second = rest.find(',');
+    const auto third = second == std::string::npos ? second : rest.find(',', second + 1);
+    auto* workspace = findWorkspace(rest.substr(0, second));
+    if (third == std::string::npos || workspace == nullptr) {
+      stale_ = true;
+      return;
+    }
+    if (findClient(first) != nullptr) {
+      return;
+    }
+    Json::Value client(Json::objectValue);
+    client["address"] = "0x" + first;
+    client["mapped"] = true;
+    client["hidden"] = false;
+    client["workspace"]["id"] = (*workspace)["id"];
+    client["workspace"]["name"] = (*workspace)["name"];
+    client["floating"] = false;
+    client["monitor"] = (*workspace)["monitorID"];
+    client["class"] = client["initialClass"] = rest.substr(second + 1, third - second - 1);
+    client["title"] = client["initialTitle"] = rest.substr(third + 1);
+    client["fullscreen"] = false;
+    client["grouped"] = Json::Value(Json::arrayValue);
+    client["swallowing"] = "0x0";
+    addWindows((*workspace)["id"].asInt(), 1);
+    clients_.emplace(client["address"].asString(), std::move(client));
+    clientsStale_ = true;
+  } else if (eventName == "closewindow") {
+    auto* client = findClient(payload);
+    if (client != nullptr) {
+      addWindows((*client)["workspace"]["id"].asInt(), -1);
+      clients_.erase((*client)["address"].asString());
+    }
+  } else if (eventName == "movewindow") {
+    auto* client = findClient(first);
+    auto* workspace = findWorkspace(rest);
+    if (client == nullptr || workspace == nullptr) {
+      stale_ = true;
+    } else {
+      addWindows((*client)["workspace"]["id"].asInt(), -1);
+      (*client)["workspace"]["id"] = (*workspace)["id"];
+      (*client)["workspace"]["name"] = rest;
+      addWindows((*workspace)["id"].asInt(), 1);
+    }
+  } else if (eventName == "activewindow") {
+    activeTitle_ = rest;
+  } else if (eventName == "activewindowv2") {
+    if (auto* client = findClient(payload)) {
+      (*client)["title"] = activeTitle_;
+      auto it = workspaces_.find((*client)["workspace"]["id"].asInt());
+      if (it != workspaces_.end()) {
+        it->second["lastwindow"] = (*client)["address"];
+        it->second["lastwindowtitle"] = activeTitle_;
+      }
+    } else if (payload != ",") {
+      // focus moved to a window we don't know about
+      stale_ = true;
+    }
+  } else if (eventName == "changefloatingmode") {
+    if (auto* client = findClient(first)) {
+      (*client)["floating"] = rest == "1";
+    }
+  } else if (eventName == "fullscreen") {
+    auto* monitor = focusedMonitor();
+    if (monitor == nullptr) {
+      stale_ = true;
+    } else {
+      auto it = workspaces_.find((*monitor)["activeWorkspace"]["id"].asInt());
+      if (it != workspaces_.end()) {
+        it->second["hasfullscreen"] = payload == "1";
+        auto client = clients_.find(it->second["lastwindow"].asString());
+        if (client != clients_.end()) {
+          client->second["fullscreen"] = payload == "1";
+        }
+      }
+    }
+  } else {
+    // monitoradded and monitorremoved don't carry the monitor properties
+    stale_ = true;
+  }
+}
+
+}  // namespace waybar::modules::hyprland
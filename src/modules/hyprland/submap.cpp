@@ -34,9 +34,9 @@ auto Submap::update() -> void {
   if (submap_.empty()) {
     event_box_.hide();
   } else {
-    label_.set_markup(fmt::format(fmt::runtime(format_), submap_));
+    setMarkup(fmt::format(fmt::runtime(format_), submap_));
     if (tooltipEnabled()) {
-      label_.set_tooltip_text(submap_);
+      setTooltipText(submap_);
     }
     event_box_.show();
   }
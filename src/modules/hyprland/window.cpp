@@ -9,13 +9,16 @@
 #include <vector>
 
 #include "modules/hyprland/backend.hpp"
+#include "modules/hyprland/state.hpp"
 #include "util/rewrite_string.hpp"
 #include "util/sanitize_str.hpp"
 
 namespace waybar::modules::hyprland {
 
 Window::Window(const std::string& id, const Bar& bar, const Json::Value& config)
-    : AAppIconLabel(config, "window", id, "{title}", 0, true), bar_(bar) {
+    : AAppIconLabel(config, "window", id, "{title}", 0, true),
+      bar_(bar),
+      rewrite_(config["rewrite"]) {
   modulesReady = true;
   separate_outputs = config["separate-outputs"].asBool();
 
@@ -52,12 +55,11 @@ auto Window::update() -> void {
 
   if (!format_.empty()) {
     label_.show();
-    label_.set_markup(waybar::util::rewriteString(
-        fmt::format(fmt::runtime(format_), fmt::arg("title", window_name),
-                    fmt::arg("initialTitle", window_data_.initial_title),
-                    fmt::arg("class", window_data_.class_name),
-                    fmt::arg("initialClass", window_data_.initial_class_name)),
-        config_["rewrite"]));
+    setMarkup(rewrite_.apply(fmt::format(
+        fmt::runtime(format_), fmt::arg("title", window_name),
+        fmt::arg("initialTitle", window_data_.initial_title),
+        fmt::arg("class", window_data_.class_name),
+        fmt::arg("initialClass", window_data_.initial_class_name))));
   } else {
     label_.hide();
   }
@@ -84,14 +86,8 @@ auto Window::update() -> void {
   AAppIconLabel::update();
 }
 
-auto Window::getActiveWorkspace() -> Workspace {
-  const auto workspace = gIPC->getSocket1JsonReply("activeworkspace");
-  assert(workspace.isObject());
-  return Workspace::parse(workspace);
-}
-
-auto Window::getActiveWorkspace(const std::string& monitorName) -> Workspace {
-  const auto monitors = gIPC->getSocket1JsonReply("monitors");
+auto Window::getActiveWorkspace(const std::string& monitorName, const Json::Value& monitors,
+                                const Json::Value& workspaces) -> Workspace {
   assert(monitors.isArray());
   auto monitor = std::find_if(monitors.begin(), monitors.end(),
                               [&](Json::Value monitor) { return monitor["name"] == monitorName; });
@@ -101,7 +97,6 @@ auto Window::getActiveWorkspace(const std::string& monitorName) -> Workspace {
   }
   const int id = (*monitor)["activeWorkspace"]["id"].asInt();
 
-  const auto workspaces = gIPC->getSocket1JsonReply("workspaces");
   assert(workspaces.isArray());
   auto workspace = std::find_if(workspaces.begin(), workspaces.end(),
                                 [&](Json::Value workspace) { return workspace["id"] == id; });
@@ -127,14 +122,18 @@ auto Window::WindowData::parse(const Json::Value& value) -> Window::WindowData {
 void Window::queryActiveWorkspace() {
   std::lock_guard<std::mutex> lg(mutex_);
 
+  auto& state = gIPC->state();
   if (separate_outputs) {
-    workspace_ = getActiveWorkspace(this->bar_.output->name);
+    workspace_ =
+        getActiveWorkspace(this->bar_.output->name, state.monitors(), state.workspaces());
   } else {
-    workspace_ = getActiveWorkspace();
+    const auto workspace = state.activeWorkspace();
+    assert(workspace.isObject());
+    workspace_ = Workspace::parse(workspace);
   }
 
   if (workspace_.windows > 0) {
-    const auto clients = gIPC->getSocket1JsonReply("clients");
+    const auto clients = state.clients();
     assert(clients.isArray());
     auto active_window = std::find_if(clients.begin(), clients.end(), [&](Json::Value window) {
       return window["address"] == workspace_.last_window;
@@ -10,6 +10,7 @@
 #include <optional>
 #include <string>
 
+#include "modules/hyprland/state.hpp"
 #include "util/rewrite_string.hpp"
 
 namespace waybar::modules::hyprland {
@@ -77,7 +78,7 @@ auto Workspaces::parse_config(const Json::Value &config) -> void {
   format_window_separator_ =
       format_window_separator.isString() ? format_window_separator.asString() : " ";
 
-  window_rewrite_rules_ = config["window-rewrite"];
+  window_rewrite_rules_ = util::RewriteRules(config["window-rewrite"]);
 
   Json::Value window_rewrite_default = config["window-rewrite-default"];
   window_rewrite_default_ =
@@ -116,14 +117,11 @@ auto Workspaces::update() -> void {
 
   workspaces_to_create_.clear();
 
-  // get all active workspaces
-  auto monitors = gIPC->getSocket1JsonReply("monitors");
+  // visible workspaces are tracked by the IPC thread, don't query Hyprland from the main loop
   std::vector<std::string> visible_workspaces;
-  for (Json::Value &monitor : monitors) {
-    auto ws = monitor["activeWorkspace"];
-    if (ws.isObject() && (ws["name"].isString())) {
-      visible_workspaces.push_back(ws["name"].asString());
-    }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    visible_workspaces = visible_workspaces_;
   }
 
   for (auto &workspace : workspaces_) {
@@ -169,7 +167,7 @@ void Workspaces::onEvent(const std::string &ev) {
       workspaces_to_remove_.push_back(payload);
     }
   } else if (eventName == "createworkspace") {
-    const Json::Value workspaces_json = gIPC->getSocket1JsonReply("workspaces");
+    const Json::Value workspaces_json = gIPC->state().workspaces();
     for (Json::Value workspace_json : workspaces_json) {
       std::string name = workspace_json["name"].asString();
       if (name == payload &&
@@ -187,7 +185,7 @@ void Workspaces::onEvent(const std::string &ev) {
     std::string workspace = payload.substr(0, payload.find(','));
     std::string new_output = payload.substr(payload.find(',') + 1);
     if (bar_.output->name == new_output) {  // TODO: implement this better
-      const Json::Value workspaces_json = gIPC->getSocket1JsonReply("workspaces");
+      const Json::Value workspaces_json = gIPC->state().workspaces();
       for (Json::Value workspace_json : workspaces_json) {
         std::string name = workspace_json["name"].asString();
         if (name == workspace && bar_.output->name == workspace_json["monitor"].asString()) {
@@ -224,9 +222,25 @@ void Workspaces::onEvent(const std::string &ev) {
     }
   }
 
+  if (eventName == "workspace" || eventName == "focusedmon" || eventName == "moveworkspace" ||
+      eventName == "createworkspace" || eventName == "destroyworkspace" ||
+      eventName == "renameworkspace") {
+    update_visible_workspaces(gIPC->state().monitors());
+  }
+
   dp.emit();
 }
 
+void Workspaces::update_visible_workspaces(const Json::Value &monitors) {
+  visible_workspaces_.clear();
+  for (const Json::Value &monitor : monitors) {
+    auto ws = monitor["activeWorkspace"];
+    if (ws.isObject() && (ws["name"].isString())) {
+      visible_workspaces_.push_back(ws["name"].asString());
+    }
+  }
+}
+
 void Workspaces::on_window_opened(std::string payload) {
   size_t last_comma_idx = 0;
   size_t next_comma_idx = payload.find(',');
@@ -289,7 +303,10 @@ void Workspaces::on_window_moved(std::string payload) {
 }
 
 void Workspaces::update_window_count() {
-  const Json::Value workspaces_json = gIPC->getSocket1JsonReply("workspaces");
+  update_window_count(gIPC->state().workspaces());
+}
+
+void Workspaces::update_window_count(const Json::Value &workspaces_json) {
   for (auto &workspace : workspaces_) {
     auto workspace_json = std::find_if(
         workspaces_json.begin(), workspaces_json.end(),
@@ -307,7 +324,7 @@ void Workspaces::update_window_count() {
 }
 
 void Workspaces::initialize_window_maps() {
-  Json::Value clients_data = gIPC->getSocket1JsonReply("clients");
+  Json::Value clients_data = gIPC->state().clients();
   for (auto &workspace : workspaces_) {
     workspace->initialize_window_map(clients_data);
   }
@@ -490,11 +507,15 @@ void Workspaces::create_persistent_workspaces() {
 }
 
 void Workspaces::init() {
-  active_workspace_name_ = (gIPC->getSocket1JsonReply("activeworkspace"))["name"].asString();
+  auto &state = gIPC->state();
+  const Json::Value monitors = state.monitors();
+  const Json::Value workspaces_json = state.workspaces();
+  const Json::Value clients_json = state.clients();
+
+  active_workspace_name_ = state.activeWorkspace()["name"].asString();
 
   // get monitor ID from name (used by persistent workspaces)
   monitor_id_ = 0;
-  auto monitors = gIPC->getSocket1JsonReply("monitors");
   auto current_monitor = std::find_if(
       monitors.begin(), monitors.end(),
       [this](const Json::Value &m) { return m["name"].asString() == bar_.output->name; });
@@ -503,13 +524,11 @@ void Workspaces::init() {
   } else {
     monitor_id_ = (*current_monitor)["id"].asInt();
   }
+  update_visible_workspaces(monitors);
 
   fill_persistent_workspaces();
   create_persistent_workspaces();
 
-  const Json::Value workspaces_json = gIPC->getSocket1JsonReply("workspaces");
-  const Json::Value clients_json = gIPC->getSocket1JsonReply("clients");
-
   for (Json::Value workspace_json : workspaces_json) {
     if ((all_outputs() || bar_.output->name == workspace_json["monitor"].asString()) &&
         (!workspace_json["name"].asString().starts_with("special") || show_special())) {
@@ -517,7 +536,7 @@ void Workspaces::init() {
     }
   }
 
-  update_window_count();
+  update_window_count(workspaces_json);
 
   sort_workspaces();
 
@@ -731,14 +750,15 @@ std::string &Workspace::select_icon(std::map<std::string, std::string> &icons_ma
 
 auto Workspace::handle_clicked(GdkEventButton *bt) -> bool {
   try {
+    // dispatch from the IPC worker, the resulting events will update the bar
     if (id() > 0) {  // normal or numbered persistent
-      gIPC->getSocket1Reply("dispatch workspace " + std::to_string(id()));
+      gIPC->getSocket1ReplyAsync("dispatch workspace " + std::to_string(id()));
     } else if (!is_special()) {  // named
-      gIPC->getSocket1Reply("dispatch workspace name:" + name());
+      gIPC->getSocket1ReplyAsync("dispatch workspace name:" + name());
     } else if (id() != -99) {  // named special
-      gIPC->getSocket1Reply("dispatch togglespecialworkspace " + name());
+      gIPC->getSocket1ReplyAsync("dispatch togglespecialworkspace " + name());
     } else {  // special
-      gIPC->getSocket1Reply("dispatch togglespecialworkspace");
+      gIPC->getSocket1ReplyAsync("dispatch togglespecialworkspace");
     }
     return true;
   } catch (const std::exception &e) {
@@ -748,7 +768,7 @@ auto Workspace::handle_clicked(GdkEventButton *bt) -> bool {
 }
 
 void Workspaces::set_urgent_workspace(std::string windowaddress) {
-  const Json::Value clients_json = gIPC->getSocket1JsonReply("clients");
+  const Json::Value clients_json = gIPC->state().clients();
   int workspace_id = -1;
 
   for (Json::Value client_json : clients_json) {
@@ -767,21 +787,14 @@ void Workspaces::set_urgent_workspace(std::string windowaddress) {
 }
 
 std::string Workspaces::get_rewrite(std::string window_class) {
-  if (regex_cache_.contains(window_class)) {
-    return regex_cache_[window_class];
-  }
-
   bool matched_any;
 
-  std::string window_class_rewrite =
-      waybar::util::rewriteStringOnce(window_class, window_rewrite_rules_, matched_any);
+  std::string window_class_rewrite = window_rewrite_rules_.applyOnce(window_class, matched_any);
 
   if (!matched_any) {
     window_class_rewrite = window_rewrite_default_;
   }
 
-  regex_cache_.emplace(window_class, window_class_rewrite);
-
   return window_class_rewrite;
 }
 
@@ -49,13 +49,13 @@ waybar::modules::IdleInhibitor::~IdleInhibitor() {
 auto waybar::modules::IdleInhibitor::update() -> void {
   // Check status
   if (status) {
-    label_.get_style_context()->remove_class("deactivated");
+    setClass("deactivated", false);
     if (idle_inhibitor_ == nullptr) {
       idle_inhibitor_ = zwp_idle_inhibit_manager_v1_create_inhibitor(
           waybar::Client::inst()->idle_inhibit_manager, bar_.surface);
     }
   } else {
-    label_.get_style_context()->remove_class("activated");
+    setClass("activated", false);
     if (idle_inhibitor_ != nullptr) {
       zwp_idle_inhibitor_v1_destroy(idle_inhibitor_);
       idle_inhibitor_ = nullptr;
@@ -63,15 +63,15 @@ auto waybar::modules::IdleInhibitor::update() -> void {
   }
 
   std::string status_text = status ? "activated" : "deactivated";
-  label_.set_markup(fmt::format(fmt::runtime(format_), fmt::arg("status", status_text),
-                                fmt::arg("icon", getIcon(0, status_text))));
-  label_.get_style_context()->add_class(status_text);
+  setMarkup(fmt::format(fmt::runtime(format_), fmt::arg("status", status_text),
+                        fmt::arg("icon", getIcon(0, status_text))));
+  setClass(status_text, true);
   if (tooltipEnabled()) {
     auto config = config_[status ? "tooltip-format-activated" : "tooltip-format-deactivated"];
     auto tooltip_format = config.isString() ? config.asString() : "{status}";
-    label_.set_tooltip_markup(fmt::format(fmt::runtime(tooltip_format),
-                                          fmt::arg("status", status_text),
-                                          fmt::arg("icon", getIcon(0, status_text))));
+    setTooltipMarkup(fmt::format(fmt::runtime(tooltip_format),
+                                 fmt::arg("status", status_text),
+                                 fmt::arg("icon", getIcon(0, status_text))));
   }
   // Call parent update
   ALabel::update();
@@ -15,6 +15,11 @@ waybar::modules::Image::Image(const std::string& id, const Json::Value& config)
 
   interval_ = config_["interval"].asInt();
 
+  if (config_["exec-timeout"].isNumeric()) {
+    limits_.timeout =
+        std::chrono::milliseconds(static_cast<int64_t>(config_["exec-timeout"].asDouble() * 1000));
+  }
+
   if (size_ == 0) {
     size_ = 16;
   }
@@ -27,16 +32,12 @@ waybar::modules::Image::Image(const std::string& id, const Json::Value& config)
 }
 
 void waybar::modules::Image::delayWorker() {
-  thread_ = [this] {
-    dp.emit();
-    auto interval = std::chrono::seconds(interval_);
-    thread_.sleep_for(interval);
-  };
+  timer_ = util::Scheduler::inst().every(std::chrono::seconds(interval_), [this] { dp.emit(); });
 }
 
 void waybar::modules::Image::refresh(int sig) {
   if (sig == SIGRTMIN + config_["signal"].asInt()) {
-    thread_.wake_up();
+    timer_.wake_up();
   }
 }
 
@@ -45,7 +46,7 @@ auto waybar::modules::Image::update() -> void {
   if (config_["path"].isString()) {
     path_ = config_["path"].asString();
   } else if (config_["exec"].isString()) {
-    output_ = util::command::exec(config_["exec"].asString());
+    output_ = util::command::exec(config_["exec"].asString(), limits_);
     parseOutputRaw();
   } else {
     path_ = "";
@@ -7,10 +7,7 @@ JACK::JACK(const std::string &id, const Json::Value &config)
   running_ = false;
   client_ = NULL;
 
-  thread_ = [this] {
-    dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  timer_ = util::Scheduler::inst().every(interval_, [this] { dp.emit(); });
 }
 
 std::string JACK::JACKState() {
@@ -55,14 +52,13 @@ auto JACK::update() -> void {
   std::string state = JACKState();
   float latency = 1000 * (float)bufsize_ / (float)samplerate_;
 
-  if (label_.get_style_context()->has_class("xrun")) {
-    label_.get_style_context()->remove_class("xrun");
+  if (hasClass("xrun")) {
+    setClass("xrun", false);
     state = "connected";
   }
 
-  if (label_.get_style_context()->has_class(state_))
-    label_.get_style_context()->remove_class(state_);
-  label_.get_style_context()->add_class(state);
+  setClass(state_, false);
+  setClass(state, true);
   state_ = state;
 
   if (config_["format-" + state].isString()) {
@@ -72,15 +68,15 @@ auto JACK::update() -> void {
   } else
     format = "{load}%";
 
-  label_.set_markup(fmt::format(fmt::runtime(format), fmt::arg("load", std::round(load_)),
-                                fmt::arg("bufsize", bufsize_), fmt::arg("samplerate", samplerate_),
-                                fmt::arg("latency", fmt::format("{:.2f}", latency)),
-                                fmt::arg("xruns", xruns_)));
+  setMarkup(fmt::format(fmt::runtime(format), fmt::arg("load", std::round(load_)),
+                        fmt::arg("bufsize", bufsize_), fmt::arg("samplerate", samplerate_),
+                        fmt::arg("latency", fmt::format("{:.2f}", latency)),
+                        fmt::arg("xruns", xruns_)));
 
   if (tooltipEnabled()) {
     std::string tooltip_format = "{bufsize}/{samplerate} {latency}ms";
     if (config_["tooltip-format"].isString()) tooltip_format = config_["tooltip-format"].asString();
-    label_.set_tooltip_text(fmt::format(
+    setTooltipText(fmt::format(
         fmt::runtime(tooltip_format), fmt::arg("load", std::round(load_)),
         fmt::arg("bufsize", bufsize_), fmt::arg("samplerate", samplerate_),
         fmt::arg("latency", fmt::format("{:.2f}", latency)), fmt::arg("xruns", xruns_)));
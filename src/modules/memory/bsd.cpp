@@ -79,7 +79,8 @@ static uint64_t get_free_memory() {
 #endif
 }
 
-void waybar::modules::Memory::parseMeminfo() {
-  meminfo_["MemTotal"] = get_total_memory() / 1024;
-  meminfo_["MemAvailable"] = get_free_memory() / 1024;
+void waybar::modules::Memory::Reader::parseMeminfo(Meminfo& meminfo) {
+  meminfo = Meminfo{};
+  meminfo.set(Meminfo::MemTotal, get_total_memory() / 1024);
+  meminfo.set(Meminfo::MemAvailable, get_free_memory() / 1024);
 }
@@ -1,33 +1,34 @@
 #include "modules/memory.hpp"
 
 waybar::modules::Memory::Memory(const std::string& id, const Json::Value& config)
-    : ALabel(config, "memory", id, "{}%", 30) {
-  thread_ = [this] {
+    : ALabel(config, "memory", id, "{}%", 30), percentage_history_(util::graphLength(config)) {
+  auto sampler = util::Sampler<Meminfo>::get("memory", [] {
+    return [reader = std::make_shared<Reader>()](Meminfo& meminfo) {
+      reader->parseMeminfo(meminfo);
+    };
+  });
+  sampler_ = sampler->subscribe(interval_, [this] {
+    new_sample_ = true;
     dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  });
 }
 
 auto waybar::modules::Memory::update() -> void {
-  parseMeminfo();
+  const auto snapshot = sampler_.latest();
+  const auto& meminfo = *snapshot;
 
-  unsigned long memtotal = meminfo_["MemTotal"];
-  unsigned long swaptotal = 0;
-  if (meminfo_.count("SwapTotal")) {
-    swaptotal = meminfo_["SwapTotal"];
-  }
+  unsigned long memtotal = meminfo[Meminfo::MemTotal];
+  unsigned long swaptotal = meminfo[Meminfo::SwapTotal];
   unsigned long memfree;
-  unsigned long swapfree = 0;
-  if (meminfo_.count("SwapFree")) {
-    swapfree = meminfo_["SwapFree"];
-  }
-  if (meminfo_.count("MemAvailable")) {
+  unsigned long swapfree = meminfo[Meminfo::SwapFree];
+  if (meminfo.has(Meminfo::MemAvailable)) {
     // New kernels (3.4+) have an accurate available memory field.
-    memfree = meminfo_["MemAvailable"] + meminfo_["zfs_size"];
+    memfree = meminfo[Meminfo::MemAvailable] + meminfo[Meminfo::ZfsSize];
   } else {
     // Old kernel; give a best-effort approximation of available memory.
-    memfree = meminfo_["MemFree"] + meminfo_["Buffers"] + meminfo_["Cached"] +
-              meminfo_["SReclaimable"] - meminfo_["Shmem"] + meminfo_["zfs_size"];
+    memfree = meminfo[Meminfo::MemFree] + meminfo[Meminfo::Buffers] + meminfo[Meminfo::Cached] +
+              meminfo[Meminfo::SReclaimable] - meminfo[Meminfo::Shmem] +
+              meminfo[Meminfo::ZfsSize];
   }
 
   if (memtotal > 0 && memfree >= 0) {
@@ -43,40 +44,52 @@ auto waybar::modules::Memory::update() -> void {
     float used_swap_gigabytes = 0.01 * round((swaptotal - swapfree) / 10485.76);
     float available_ram_gigabytes = 0.01 * round(memfree / 10485.76);
     float available_swap_gigabytes = 0.01 * round(swapfree / 10485.76);
+    if (new_sample_.exchange(false)) {
+      percentage_history_.push(used_ram_percentage);
+    }
 
     auto format = format_;
     auto state = getState(used_ram_percentage);
     if (!state.empty() && config_["format-" + state].isString()) {
       format = config_["format-" + state].asString();
     }
+    auto icons = std::vector<std::string>{state};
+    auto lookup = [&](std::string_view name, util::FormatTemplate::Writer& out) {
+      if (name == "percentage" || name == "0") {
+        out.write(used_ram_percentage);
+      } else if (name == "icon") {
+        out.write(getIcon(used_ram_percentage, icons));
+      } else if (name == "total") {
+        out.write(total_ram_gigabytes);
+      } else if (name == "swapTotal") {
+        out.write(total_swap_gigabytes);
+      } else if (name == "swapPercentage") {
+        out.write(used_swap_percentage);
+      } else if (name == "used") {
+        out.write(used_ram_gigabytes);
+      } else if (name == "swapUsed") {
+        out.write(used_swap_gigabytes);
+      } else if (name == "avail") {
+        out.write(available_ram_gigabytes);
+      } else if (name == "swapAvail") {
+        out.write(available_swap_gigabytes);
+      } else if (name == "percentageGraph") {
+        out.write(percentage_history_.sparkline(0, 100));
+      }
+    };
 
     if (format.empty()) {
       event_box_.hide();
     } else {
       event_box_.show();
-      auto icons = std::vector<std::string>{state};
-      label_.set_markup(fmt::format(
-          fmt::runtime(format), used_ram_percentage,
-          fmt::arg("icon", getIcon(used_ram_percentage, icons)),
-          fmt::arg("total", total_ram_gigabytes), fmt::arg("swapTotal", total_swap_gigabytes),
-          fmt::arg("percentage", used_ram_percentage),
-          fmt::arg("swapPercentage", used_swap_percentage), fmt::arg("used", used_ram_gigabytes),
-          fmt::arg("swapUsed", used_swap_gigabytes), fmt::arg("avail", available_ram_gigabytes),
-          fmt::arg("swapAvail", available_swap_gigabytes)));
+      setMarkup(getTemplate(format).render(lookup));
     }
 
     if (tooltipEnabled()) {
       if (config_["tooltip-format"].isString()) {
-        auto tooltip_format = config_["tooltip-format"].asString();
-        label_.set_tooltip_text(fmt::format(
-            fmt::runtime(tooltip_format), used_ram_percentage,
-            fmt::arg("total", total_ram_gigabytes), fmt::arg("swapTotal", total_swap_gigabytes),
-            fmt::arg("percentage", used_ram_percentage),
-            fmt::arg("swapPercentage", used_swap_percentage), fmt::arg("used", used_ram_gigabytes),
-            fmt::arg("swapUsed", used_swap_gigabytes), fmt::arg("avail", available_ram_gigabytes),
-            fmt::arg("swapAvail", available_swap_gigabytes)));
+        setTooltipText(getTemplate(config_["tooltip-format"].asString()).render(lookup));
       } else {
-        label_.set_tooltip_text(fmt::format("{:.{}f}GiB used", used_ram_gigabytes, 1));
+        setTooltipText(fmt::format("{:.{}f}GiB used", used_ram_gigabytes, 1));
       }
     }
   } else {
@@ -1,43 +1,108 @@
+#include <array>
+#include <string_view>
+#include <utility>
+
 #include "modules/memory.hpp"
 
-static unsigned zfsArcSize() {
-  std::ifstream zfs_arc_stats{"/proc/spl/kstat/zfs/arcstats"};
+namespace {
 
-  if (zfs_arc_stats.is_open()) {
-    std::string name;
-    std::string type;
-    unsigned long data{0};
+using Meminfo = waybar::modules::Memory::Meminfo;
 
-    std::string line;
-    while (std::getline(zfs_arc_stats, line)) {
-      std::stringstream(line) >> name >> type >> data;
+constexpr std::pair<std::string_view, Meminfo::Key> meminfo_keys[] = {
+    {"MemTotal", Meminfo::MemTotal},
+    {"MemFree", Meminfo::MemFree},
+    {"MemAvailable", Meminfo::MemAvailable},
+    {"Buffers", Meminfo::Buffers},
+    {"Cached", Meminfo::Cached},
+    {"SReclaimable", Meminfo::SReclaimable},
+    {"Shmem", Meminfo::Shmem},
+    {"SwapTotal", Meminfo::SwapTotal},
+    {"SwapFree", Meminfo::SwapFree},
+};
 
-      if (name == "size") {
-        return data / 1024;  // convert to kB
-      }
-    }
+// Perfect hash over meminfo_keys, other names are rejected by comparing the key of their slot
+constexpr size_t kSlots = 16;
+
+constexpr size_t slotOf(std::string_view name) {
+  return (name.size() + name.front() + name.back()) % kSlots;
+}
+
+constexpr std::array<int, kSlots> makeSlots() {
+  std::array<int, kSlots> slots{};
+  for (auto& slot : slots) slot = -1;
+  for (size_t i = 0; i < std::size(meminfo_keys); ++i) {
+    slots[slotOf(meminfo_keys[i].first)] = i;
   }
+  return slots;
+}
 
-  return 0;
+constexpr auto meminfo_slots = makeSlots();
+
+constexpr bool isPerfect() {
+  for (size_t i = 0; i < std::size(meminfo_keys); ++i) {
+    if (meminfo_slots[slotOf(meminfo_keys[i].first)] != static_cast<int>(i)) return false;
+  }
+  return true;
+}
+static_assert(isPerfect(), "meminfo keys collide, adjust slotOf()");
+
+const std::pair<std::string_view, Meminfo::Key>* findKey(std::string_view name) {
+  if (name.empty()) return nullptr;
+  const auto index = meminfo_slots[slotOf(name)];
+  if (index == -1 || meminfo_keys[index].first != name) return nullptr;
+  return &meminfo_keys[index];
 }
 
-void waybar::modules::Memory::parseMeminfo() {
-  const std::string data_dir_ = "/proc/meminfo";
-  std::ifstream info(data_dir_);
-  if (!info.is_open()) {
-    throw std::runtime_error("Can't open " + data_dir_);
+unsigned long parseUint(const char*& p, const char* end) {
+  while (p < end && (*p < '0' || *p > '9') && *p != '\n') ++p;
+  unsigned long value = 0;
+  for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+    value = value * 10 + (*p - '0');
   }
-  std::string line;
-  while (getline(info, line)) {
-    auto posDelim = line.find(':');
-    if (posDelim == std::string::npos) {
-      continue;
+  return value;
+}
+
+const char* nextLine(const char* p, const char* end) {
+  while (p < end && *p != '\n') ++p;
+  return p < end ? p + 1 : end;
+}
+
+}  // namespace
+
+// Size of the ARC in kB, from lines like "size    4    1234567"
+static unsigned long zfsArcSize(waybar::util::ProcFile& arcstats) {
+  const auto data = arcstats.read();
+  const char* const end = data.data() + data.size();
+  for (const char* p = data.data(); p < end; p = nextLine(p, end)) {
+    if (end - p > 5 && std::string_view(p, 5) == "size ") {
+      p += 5;
+      parseUint(p, end);  // type
+      return parseUint(p, end) / 1024;
     }
+  }
+  return 0;
+}
 
-    std::string name = line.substr(0, posDelim);
-    int64_t value = std::stol(line.substr(posDelim + 1));
-    meminfo_[name] = value;
+void waybar::modules::Memory::Reader::parseMeminfo(Meminfo& meminfo) {
+  const auto data = proc_meminfo_.read();
+  const char* const end = data.data() + data.size();
+  meminfo = Meminfo{};
+  for (const char* p = data.data(); p < end; p = nextLine(p, end)) {
+    const char* colon = p;
+    while (colon < end && *colon != ':' && *colon != '\n') ++colon;
+    if (colon == end || *colon != ':') continue;
+    if (const auto* key = findKey(std::string_view(p, colon - p))) {
+      p = colon + 1;
+      meminfo.set(key->second, parseUint(p, end));
+    }
   }
 
-  meminfo_["zfs_size"] = zfsArcSize();
+  if (has_zfs_) {
+    try {
+      meminfo.set(Meminfo::ZfsSize, zfsArcSize(zfs_arcstats_));
+    } catch (const std::exception&) {
+      // Not using ZFS, don't try again
+      has_zfs_ = false;
+    }
+  }
 }
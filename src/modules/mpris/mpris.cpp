@@ -164,10 +164,7 @@ Mpris::Mpris(const std::string& id, const Json::Value& config)
 
   // allow setting an interval count that triggers periodic refreshes
   if (interval_.count() > 0) {
-    thread_ = [this] {
-      dp.emit();
-      thread_.sleep_for(interval_);
-    };
+    timer_ = util::Scheduler::inst().every(interval_, [this] { dp.emit(); });
   }
 
   // trigger initial update
@@ -630,21 +627,17 @@ auto Mpris::update() -> void {
   spdlog::debug("mpris[{}]: running update", info.name);
 
   // set css class for player status
-  if (!lastStatus.empty() && label_.get_style_context()->has_class(lastStatus)) {
-    label_.get_style_context()->remove_class(lastStatus);
-  }
-  if (!label_.get_style_context()->has_class(info.status_string)) {
-    label_.get_style_context()->add_class(info.status_string);
+  if (!lastStatus.empty() && lastStatus != info.status_string) {
+    setClass(lastStatus, false);
   }
+  setClass(info.status_string, true);
   lastStatus = info.status_string;
 
   // set css class for player name
-  if (!lastPlayer.empty() && label_.get_style_context()->has_class(lastPlayer)) {
-    label_.get_style_context()->remove_class(lastPlayer);
-  }
-  if (!label_.get_style_context()->has_class(info.name)) {
-    label_.get_style_context()->add_class(info.name);
+  if (!lastPlayer.empty() && lastPlayer != info.name) {
+    setClass(lastPlayer, false);
   }
+  setClass(info.name, true);
   lastPlayer = info.name;
 
   auto formatstr = format_;
@@ -688,7 +681,7 @@ auto Mpris::update() -> void {
     if (label_format.empty()) {
       label_.hide();
     } else {
-      label_.set_markup(label_format);
+      setMarkup(label_format);
       label_.show();
     }
   } catch (fmt::format_error const& e) {
@@ -708,7 +701,7 @@ auto Mpris::update() -> void {
           fmt::arg("player_icon", getIconFromJson(config_["player-icons"], info.name)),
           fmt::arg("status_icon", getIconFromJson(config_["status-icons"], info.status_string)));
 
-      label_.set_tooltip_text(tooltip_text);
+      setTooltipText(tooltip_text);
     } catch (fmt::format_error const& e) {
       spdlog::warn("mpris: format error (tooltip): {}", e.what());
     }
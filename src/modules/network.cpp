@@ -5,11 +5,13 @@
 #include <sys/eventfd.h>
 
 #include <cassert>
-#include <fstream>
+#include <charconv>
+#include <cmath>
 #include <optional>
-#include <sstream>
+#include <string_view>
 
 #include "util/format.hpp"
+#include "util/proc_file.hpp"
 #ifdef WANT_RFKILL
 #include "util/rfkill.hpp"
 #endif
@@ -17,66 +19,69 @@
 namespace {
 using namespace waybar::util;
 constexpr const char *DEFAULT_FORMAT = "{ifname}";
-}  // namespace
 
-constexpr const char *NETDEV_FILE =
-    "/proc/net/dev";  // std::ifstream does not take std::string_view as param
-std::optional<std::pair<unsigned long long, unsigned long long>>
-waybar::modules::Network::readBandwidthUsage() {
-  std::ifstream netdev(NETDEV_FILE);
-  if (!netdev) {
-    spdlog::warn("Failed to open netdev file {}", NETDEV_FILE);
-    return {};
-  }
-
-  std::string line;
-  // skip the headers (first two lines)
-  std::getline(netdev, line);
-  std::getline(netdev, line);
-
-  unsigned long long receivedBytes = 0ull;
-  unsigned long long transmittedBytes = 0ull;
-  while (std::getline(netdev, line)) {
-    std::istringstream iss(line);
-
-    std::string ifacename;
-    iss >> ifacename;      // ifacename contains "eth0:"
-    ifacename.pop_back();  // remove trailing ':'
-    if (ifacename != ifname_) {
-      continue;
-    }
+using Counters = waybar::modules::Network::BandwidthCounters;
+
+uint64_t parseCounter(std::string_view data) {
+  uint64_t value = 0;
+  std::from_chars(data.data(), data.data() + data.size(), value);
+  return value;
+}
+
+// Next whitespace separated field of `line`, which is advanced past it
+std::string_view nextField(std::string_view &line) {
+  const auto start = std::min(line.find_first_not_of(' '), line.size());
+  const auto end = std::min(line.find(' ', start), line.size());
+  auto field = line.substr(start, end - start);
+  line.remove_prefix(end);
+  return field;
+}
 
-    // The rest of the line consists of whitespace separated counts divided
-    // into two groups (receive and transmit). Each group has the following
-    // columns: bytes, packets, errs, drop, fifo, frame, compressed, multicast
-    //
-    // We only care about the bytes count, so we'll just ignore the 7 other
-    // columns.
-    unsigned long long r = 0ull;
-    unsigned long long t = 0ull;
-    // Read received bytes
-    iss >> r;
-    // Skip all the other columns in the received group
-    for (int colsToSkip = 7; colsToSkip > 0; colsToSkip--) {
-      // skip whitespace between columns
-      while (iss.peek() == ' ') {
-        iss.ignore();
+// Reads the statistics of a single interface from sysfs, two pread() per sample
+Sampler<Counters>::Reader interfaceReader(const std::string &ifname) {
+  const auto dir = "/sys/class/net/" + ifname + "/statistics/";
+  return [rx = std::make_shared<ProcFile>(dir + "rx_bytes"),
+          tx = std::make_shared<ProcFile>(dir + "tx_bytes")](Counters &counters) {
+    counters.time = std::chrono::steady_clock::now();
+    counters.down = parseCounter(rx->read());
+    counters.up = parseCounter(tx->read());
+  };
+}
+
+// Sums the counters of all interfaces but loopback from /proc/net/dev
+Sampler<Counters>::Reader aggregateReader() {
+  return [netdev = std::make_shared<ProcFile>("/proc/net/dev")](Counters &counters) {
+    auto data = netdev->read();
+    counters.time = std::chrono::steady_clock::now();
+    counters.down = 0;
+    counters.up = 0;
+    // Skip the two header lines. The others look like "  eth0: <8 rx columns> <8 tx columns>",
+    // of which we want the first column of each group, the byte counts.
+    for (size_t line_no = 0; !data.empty(); ++line_no) {
+      const auto eol = std::min(data.find('\n'), data.size());
+      auto line = data.substr(0, eol);
+      data.remove_prefix(std::min(eol + 1, data.size()));
+      const auto colon = line.find(':');
+      if (line_no < 2 || colon == std::string_view::npos) {
+        continue;
+      }
+      auto ifname = line.substr(0, colon);
+      ifname.remove_prefix(std::min(ifname.find_first_not_of(' '), ifname.size()));
+      if (ifname == "lo") {
+        continue;
       }
-      // skip the irrelevant column
-      while (iss.peek() != ' ') {
-        iss.ignore();
+      line.remove_prefix(colon + 1);
+      counters.down += parseCounter(nextField(line));
+      for (int skip = 7; skip > 0; --skip) {
+        nextField(line);
       }
+      counters.up += parseCounter(nextField(line));
     }
-    // Read transmit bytes
-    iss >> t;
-
-    receivedBytes += r;
-    transmittedBytes += t;
-  }
-
-  return {{receivedBytes, transmittedBytes}};
+  };
 }
 
+}  // namespace
+
 waybar::modules::Network::Network(const std::string &id, const Json::Value &config)
     : ALabel(config, "network", id, DEFAULT_FORMAT, 60),
       ifid_(-1),
@@ -88,6 +93,11 @@ waybar::modules::Network::Network(const std::string &id, const Json::Value &conf
       want_addr_dump_(false),
       dump_in_progress_(false),
       is_p2p_(false),
+      bandwidth_aggregate_(config["bandwidth-aggregate"].asBool()),
+      bandwidth_down_(0),
+      bandwidth_up_(0),
+      bandwidth_down_history_(graphLength(config)),
+      bandwidth_up_history_(graphLength(config)),
       cidr_(0),
       signal_strength_dbm_(0),
       signal_strength_(0),
@@ -100,15 +110,16 @@ waybar::modules::Network::Network(const std::string &id, const Json::Value &conf
   // update it. Since the text should be different, update() will be able
   // to show or hide the event_box_. This is to work around the case where
   // the module start with no text, but the event_box_ is shown.
-  label_.set_markup("<s></s>");
+  setMarkup("<s></s>");
 
-  auto bandwidth = readBandwidthUsage();
-  if (bandwidth.has_value()) {
-    bandwidth_down_total_ = (*bandwidth).first;
-    bandwidth_up_total_ = (*bandwidth).second;
-  } else {
-    bandwidth_down_total_ = 0;
-    bandwidth_up_total_ = 0;
+  // Sub-second intervals are allowed, e.g. for a graph of the bandwidth
+  bandwidth_interval_ = interval_;
+  if (config_["bandwidth-interval"].isNumeric()) {
+    bandwidth_interval_ = std::chrono::milliseconds(
+        std::max(100L, std::lround(config_["bandwidth-interval"].asDouble() * 1000)));
+  }
+  if (bandwidth_aggregate_) {
+    subscribeBandwidth("network", aggregateReader);
   }
 
   if (!config_["interface"].isString()) {
@@ -294,24 +305,14 @@ auto waybar::modules::Network::update() -> void {
   std::lock_guard<std::mutex> lock(mutex_);
   std::string tooltip_format;
 
-  auto bandwidth = readBandwidthUsage();
-  auto bandwidth_down = 0ull;
-  auto bandwidth_up = 0ull;
-  if (bandwidth.has_value()) {
-    auto down_octets = (*bandwidth).first;
-    auto up_octets = (*bandwidth).second;
-
-    bandwidth_down = down_octets - bandwidth_down_total_;
-    bandwidth_down_total_ = down_octets;
-
-    bandwidth_up = up_octets - bandwidth_up_total_;
-    bandwidth_up_total_ = up_octets;
-  }
+  updateBandwidth();
+  const auto bandwidth_down = std::llround(bandwidth_down_);
+  const auto bandwidth_up = std::llround(bandwidth_up_);
 
   if (!alt_) {
     auto state = getNetworkState();
-    if (!state_.empty() && label_.get_style_context()->has_class(state_)) {
-      label_.get_style_context()->remove_class(state_);
+    if (!state_.empty() && state_ != state) {
+      setClass(state_, false);
     }
     if (config_["format-" + state].isString()) {
       default_format_ = config_["format-" + state].asString();
@@ -323,35 +324,62 @@ auto waybar::modules::Network::update() -> void {
     if (config_["tooltip-format-" + state].isString()) {
       tooltip_format = config_["tooltip-format-" + state].asString();
     }
-    if (!label_.get_style_context()->has_class(state)) {
-      label_.get_style_context()->add_class(state);
-    }
+    setClass(state, true);
     format_ = default_format_;
     state_ = state;
   }
   getState(signal_strength_);
 
-  auto text = fmt::format(
-      fmt::runtime(format_), fmt::arg("essid", essid_), fmt::arg("signaldBm", signal_strength_dbm_),
-      fmt::arg("signalStrength", signal_strength_),
-      fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
-      fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_), fmt::arg("gwaddr", gwaddr_),
-      fmt::arg("cidr", cidr_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
-      fmt::arg("icon", getIcon(signal_strength_, state_)),
-      fmt::arg("bandwidthDownBits", pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthTotalBits",
-               pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-      fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-      fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-      fmt::arg("bandwidthTotalOctets",
-               pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-      fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-      fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-      fmt::arg("bandwidthTotalBytes",
-               pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
-  if (text.compare(label_.get_label()) != 0) {
-    label_.set_markup(text);
+  auto lookup = [&](std::string_view name, util::FormatTemplate::Writer& out) {
+    if (name == "essid") {
+      out.write(essid_);
+    } else if (name == "signaldBm") {
+      out.write(signal_strength_dbm_);
+    } else if (name == "signalStrength") {
+      out.write(signal_strength_);
+    } else if (name == "signalStrengthApp") {
+      out.write(signal_strength_app_);
+    } else if (name == "ifname") {
+      out.write(ifname_);
+    } else if (name == "netmask") {
+      out.write(netmask_);
+    } else if (name == "ipaddr") {
+      out.write(ipaddr_);
+    } else if (name == "gwaddr") {
+      out.write(gwaddr_);
+    } else if (name == "cidr") {
+      out.write(cidr_);
+    } else if (name == "frequency") {
+      out.write(fmt::format("{:.1f}", frequency_));
+    } else if (name == "icon") {
+      out.write(getIcon(signal_strength_, state_));
+    } else if (name == "bandwidthDownBits") {
+      out.write(pow_format(bandwidth_down * 8ll, "b/s"));
+    } else if (name == "bandwidthUpBits") {
+      out.write(pow_format(bandwidth_up * 8ll, "b/s"));
+    } else if (name == "bandwidthTotalBits") {
+      out.write(pow_format((bandwidth_up + bandwidth_down) * 8ll, "b/s"));
+    } else if (name == "bandwidthDownOctets") {
+      out.write(pow_format(bandwidth_down, "o/s"));
+    } else if (name == "bandwidthUpOctets") {
+      out.write(pow_format(bandwidth_up, "o/s"));
+    } else if (name == "bandwidthTotalOctets") {
+      out.write(pow_format(bandwidth_up + bandwidth_down, "o/s"));
+    } else if (name == "bandwidthDownBytes") {
+      out.write(pow_format(bandwidth_down, "B/s"));
+    } else if (name == "bandwidthUpBytes") {
+      out.write(pow_format(bandwidth_up, "B/s"));
+    } else if (name == "bandwidthTotalBytes") {
+      out.write(pow_format(bandwidth_up + bandwidth_down, "B/s"));
+    } else if (name == "bandwidthDownGraph") {
+      out.write(bandwidth_down_history_.sparkline(0, bandwidth_down_history_.max()));
+    } else if (name == "bandwidthUpGraph") {
+      out.write(bandwidth_up_history_.sparkline(0, bandwidth_up_history_.max()));
+    }
+  };
+
+  const auto& text = getTemplate(format_).render(lookup);
+  if (setMarkup(text)) {
     if (text.empty()) {
       event_box_.hide();
     } else {
@@ -363,31 +391,9 @@ auto waybar::modules::Network::update() -> void {
       tooltip_format = config_["tooltip-format"].asString();
     }
     if (!tooltip_format.empty()) {
-      auto tooltip_text = fmt::format(
-          fmt::runtime(tooltip_format), fmt::arg("essid", essid_),
-          fmt::arg("signaldBm", signal_strength_dbm_), fmt::arg("signalStrength", signal_strength_),
-          fmt::arg("signalStrengthApp", signal_strength_app_), fmt::arg("ifname", ifname_),
-          fmt::arg("netmask", netmask_), fmt::arg("ipaddr", ipaddr_), fmt::arg("gwaddr", gwaddr_),
-          fmt::arg("cidr", cidr_), fmt::arg("frequency", fmt::format("{:.1f}", frequency_)),
-          fmt::arg("icon", getIcon(signal_strength_, state_)),
-          fmt::arg("bandwidthDownBits",
-                   pow_format(bandwidth_down * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthUpBits", pow_format(bandwidth_up * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthTotalBits",
-                   pow_format((bandwidth_up + bandwidth_down) * 8ull / interval_.count(), "b/s")),
-          fmt::arg("bandwidthDownOctets", pow_format(bandwidth_down / interval_.count(), "o/s")),
-          fmt::arg("bandwidthUpOctets", pow_format(bandwidth_up / interval_.count(), "o/s")),
-          fmt::arg("bandwidthTotalOctets",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "o/s")),
-          fmt::arg("bandwidthDownBytes", pow_format(bandwidth_down / interval_.count(), "B/s")),
-          fmt::arg("bandwidthUpBytes", pow_format(bandwidth_up / interval_.count(), "B/s")),
-          fmt::arg("bandwidthTotalBytes",
-                   pow_format((bandwidth_up + bandwidth_down) / interval_.count(), "B/s")));
-      if (label_.get_tooltip_text() != tooltip_text) {
-        label_.set_tooltip_markup(tooltip_text);
-      }
-    } else if (label_.get_tooltip_text() != text) {
-      label_.set_tooltip_markup(text);
+      setTooltipMarkup(getTemplate(tooltip_format).render(lookup));
+    } else {
+      setTooltipMarkup(text);
     }
   }
 
@@ -395,6 +401,50 @@ auto waybar::modules::Network::update() -> void {
   ALabel::update();
 }
 
+void waybar::modules::Network::subscribeBandwidth(
+    const std::string &key, const std::function<Sampler<Counters>::Reader()> &makeReader) {
+  try {
+    auto sampler = Sampler<Counters>::get(key, makeReader);
+    // Faster samples than the module interval update the label on their own
+    const bool emit = bandwidth_interval_ < interval_;
+    bandwidth_sampler_ = sampler->subscribe(bandwidth_interval_, [this, emit] {
+      if (emit) dp.emit();
+    });
+    bandwidth_prev_ = *bandwidth_sampler_.latest();
+  } catch (const std::exception &e) {
+    spdlog::warn("network: can't read the bandwidth: {}", e.what());
+  }
+}
+
+void waybar::modules::Network::updateBandwidth() {
+  if (!bandwidth_aggregate_ && ifname_ != bandwidth_ifname_) {
+    bandwidth_ifname_ = ifname_;
+    bandwidth_sampler_.reset();
+    bandwidth_prev_.reset();
+    bandwidth_down_ = 0;
+    bandwidth_up_ = 0;
+    if (!ifname_.empty()) {
+      subscribeBandwidth("network:" + ifname_, [this] { return interfaceReader(ifname_); });
+    }
+  }
+  if (!bandwidth_prev_) {
+    return;
+  }
+  // Updates triggered by netlink events in between samples keep the last rates
+  const auto current = bandwidth_sampler_.latest();
+  if (current->time <= bandwidth_prev_->time) {
+    return;
+  }
+  const std::chrono::duration<double> elapsed = current->time - bandwidth_prev_->time;
+  // Counters restart from 0 if the interface is recreated
+  auto delta = [](uint64_t curr, uint64_t prev) { return curr >= prev ? curr - prev : 0; };
+  bandwidth_down_ = delta(current->down, bandwidth_prev_->down) / elapsed.count();
+  bandwidth_up_ = delta(current->up, bandwidth_prev_->up) / elapsed.count();
+  bandwidth_prev_ = *current;
+  bandwidth_down_history_.push(bandwidth_down_);
+  bandwidth_up_history_.push(bandwidth_up_);
+}
+
 bool waybar::modules::Network::checkInterface(std::string name) {
   if (config_["interface"].isString()) {
     return config_["interface"].asString() == name ||
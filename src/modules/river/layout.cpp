@@ -146,7 +146,7 @@ void Layout::handle_name(const char *name) {
     label_.hide();  // hide empty labels or labels with empty format
   } else {
     label_.show();
-    label_.set_markup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(name).raw()));
+    setMarkup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(name).raw()));
   }
   ALabel::update();
 }
@@ -158,7 +158,7 @@ void Layout::handle_clear() {
 
 void Layout::handle_focused_output(struct wl_output *output) {
   if (output_ == output) {  // if we focused the output this bar belongs to
-    label_.get_style_context()->add_class("focused");
+    setClass("focused", true);
     ALabel::update();
   }
   focused_output_ = output;
@@ -166,7 +166,7 @@ void Layout::handle_focused_output(struct wl_output *output) {
 
 void Layout::handle_unfocused_output(struct wl_output *output) {
   if (output_ == output) {  // if we unfocused the output this bar belongs to
-    label_.get_style_context()->remove_class("focused");
+    setClass("focused", false);
     ALabel::update();
   }
 }
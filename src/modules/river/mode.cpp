@@ -99,11 +99,11 @@ void Mode::handle_mode(const char *mode) {
     label_.hide();
   } else {
     if (!mode_.empty()) {
-      label_.get_style_context()->remove_class(mode_);
+      setClass(mode_, false);
     }
 
-    label_.get_style_context()->add_class(mode);
-    label_.set_markup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(mode).raw()));
+    setClass(mode, true);
+    setMarkup(fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(mode).raw()));
     label_.show();
   }
 
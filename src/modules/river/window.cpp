@@ -107,9 +107,9 @@ void Window::handle_focused_view(const char *title) {
   } else {
     label_.show();
     auto text = fmt::format(fmt::runtime(format_), Glib::Markup::escape_text(title).raw());
-    label_.set_markup(text);
+    setMarkup(text);
     if (tooltipEnabled()) {
-      label_.set_tooltip_markup(text);
+      setTooltipMarkup(text);
     }
   }
 
@@ -118,7 +118,7 @@ void Window::handle_focused_view(const char *title) {
 
 void Window::handle_focused_output(struct wl_output *output) {
   if (output_ == output) {  // if we focused the output this bar belongs to
-    label_.get_style_context()->add_class("focused");
+    setClass("focused", true);
     ALabel::update();
   }
   focused_output_ = output;
@@ -126,7 +126,7 @@ void Window::handle_focused_output(struct wl_output *output) {
 
 void Window::handle_unfocused_output(struct wl_output *output) {
   if (output_ == output) {  // if we unfocused the output this bar belongs to
-    label_.get_style_context()->remove_class("focused");
+    setClass("focused", false);
     ALabel::update();
   }
 }
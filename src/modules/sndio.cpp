@@ -105,9 +105,9 @@ auto Sndio::update() -> void {
   unsigned int vol = 100. * static_cast<double>(volume_) / static_cast<double>(maxval_);
 
   if (volume_ == 0) {
-    label_.get_style_context()->add_class("muted");
+    setClass("muted", true);
   } else {
-    label_.get_style_context()->remove_class("muted");
+    setClass("muted", false);
   }
 
   auto text =
@@ -115,7 +115,7 @@ auto Sndio::update() -> void {
   if (text.empty()) {
     label_.hide();
   } else {
-    label_.set_markup(text);
+    setMarkup(text);
     label_.show();
   }
 
@@ -299,9 +299,19 @@ Glib::RefPtr<Gdk::Pixbuf> Item::extractPixBuf(GVariant* variant) {
 }
 
 void Item::updateImage() {
-  auto pixbuf = getIconPixbuf();
   auto scaled_icon_size = getScaledIconSize();
 
+  // Icons from the default theme or from files are shared with the other items and bars
+  if (!icon_name.empty() && icon_theme_path.empty()) {
+    if (auto surface = util::IconCache::inst().load(Gtk::IconTheme::get_default(), icon_name,
+                                                     scaled_icon_size, image.get_scale_factor())) {
+      image.set(surface);
+      return;
+    }
+  }
+
+  auto pixbuf = getIconPixbuf();
+
   // If the loaded icon is not square, assume that the icon height should match the
   // requested icon size, but the width is allowed to be different. As such, if the
   // height of the image does not match the requested icon size, resize the icon such that
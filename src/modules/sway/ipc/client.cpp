@@ -2,57 +2,158 @@
 
 #include <fcntl.h>
 #include <spdlog/spdlog.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <mutex>
 #include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "util/json.hpp"
 
 namespace waybar::modules::sway {
 
-Ipc::Ipc() {
-  const std::string& socketPath = getSocketPath();
-  fd_ = open(socketPath);
-  fd_event_ = open(socketPath);
-}
+namespace {
 
-Ipc::~Ipc() {
-  thread_.stop();
+constexpr std::string_view ipc_magic = "i3-ipc";
+constexpr size_t ipc_header_size = ipc_magic.size() + 8;
+constexpr uint32_t ipc_event_flag = 1U << 31;
 
-  if (fd_ > 0) {
-    // To fail the IPC header
-    if (write(fd_, "close-sway-ipc", 14) == -1) {
-      spdlog::error("Failed to close sway IPC");
-    }
-    close(fd_);
-    fd_ = -1;
+constexpr std::pair<std::string_view, uint32_t> event_types[] = {
+    {"workspace", IPC_EVENT_WORKSPACE},
+    {"output", IPC_EVENT_OUTPUT},
+    {"mode", IPC_EVENT_MODE},
+    {"window", IPC_EVENT_WINDOW},
+    {"barconfig_update", IPC_EVENT_BARCONFIG_UPDATE},
+    {"binding", IPC_EVENT_BINDING},
+    {"shutdown", IPC_EVENT_SHUTDOWN},
+    {"tick", IPC_EVENT_TICK},
+    {"bar_state_update", IPC_EVENT_BAR_STATE_UPDATE},
+    {"input", IPC_EVENT_INPUT},
+};
+
+}  // namespace
+
+/**
+ * Connection to sway shared by all Ipc clients of the process.
+ *
+ * It lives as long as at least one client does, and reconnects the event socket with a backoff if
+ * sway goes away.
+ */
+class IpcHub {
+ public:
+  static std::shared_ptr<IpcHub> inst();
+
+  IpcHub();
+  ~IpcHub();
+
+  Ipc::ipc_response request(uint32_t type, const std::string& payload);
+  void subscribe(Ipc* ipc, uint32_t events);
+  void remove(Ipc* ipc);
+
+ private:
+  static constexpr std::chrono::milliseconds kReconnectMin{100};
+  static constexpr std::chrono::milliseconds kReconnectMax{5000};
+
+  struct Client {
+    // null once removed, guarded by the mutex of the client, which is held while emitting to it
+    Ipc* ipc;
+    // event_mask() of the subscribed event types, guarded by the hub
+    uint32_t events = 0;
+    std::mutex mutex;
+  };
+
+  static std::string getSocketPath();
+  static int open(const std::string& socketPath);
+  static void send(int fd, uint32_t type, const std::string& payload);
+  static Ipc::ipc_response recv(int fd);
+  static std::string subscribePayload(uint32_t events);
+
+  void run();
+  void reconnect();
+  void dispatch(const Ipc::ipc_response& res);
+
+  const std::string socketPath_;
+  std::mutex cmdMutex_;
+  int fd_ = -1;
+
+  // guards the event socket, the subscriptions and the clients
+  std::mutex mutex_;
+  int fd_event_ = -1;
+  uint32_t events_ = 0;
+  std::vector<std::shared_ptr<Client>> clients_;
+  // clients an event is emitted to, only used by the reader thread
+  std::vector<std::shared_ptr<Client>> dispatching_;
+
+  std::atomic<bool> running_ = true;
+  util::JsonParser parser_;
+  std::thread thread_;
+};
+
+std::shared_ptr<IpcHub> IpcHub::inst() {
+  static std::mutex mutex;
+  static std::weak_ptr<IpcHub> instance;
+  std::lock_guard<std::mutex> lock(mutex);
+  auto hub = instance.lock();
+  if (!hub) {
+    hub = std::make_shared<IpcHub>();
+    instance = hub;
   }
-  if (fd_event_ > 0) {
-    if (write(fd_event_, "close-sway-ipc", 14) == -1) {
-      spdlog::error("Failed to close sway IPC event handler");
-    }
-    close(fd_event_);
-    fd_event_ = -1;
+  return hub;
+}
+
+IpcHub::IpcHub() : socketPath_(getSocketPath()) {
+  fd_ = open(socketPath_);
+  try {
+    fd_event_ = open(socketPath_);
+  } catch (...) {
+    close(fd_);
+    throw;
   }
+  thread_ = std::thread([this] { run(); });
 }
 
-void Ipc::setWorker(std::function<void()>&& func) { thread_ = func; }
+IpcHub::~IpcHub() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+    // Wake up the reader blocked in recv()
+    shutdown(fd_event_, SHUT_RDWR);
+  }
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  close(fd_event_);
+  if (fd_ != -1) {
+    close(fd_);
+  }
+}
 
-const std::string Ipc::getSocketPath() const {
+std::string IpcHub::getSocketPath() {
   const char* env = getenv("SWAYSOCK");
   if (env != nullptr) {
     return std::string(env);
   }
   std::string str;
   {
-    std::string str_buf;
     FILE* in;
     char buf[512] = {0};
     if ((in = popen("sway --get-socketpath 2>/dev/null", "r")) == nullptr) {
       throw std::runtime_error("Failed to get socket path");
     }
     while (fgets(buf, sizeof(buf), in) != nullptr) {
-      str_buf.append(buf, sizeof(buf));
+      str.append(buf);
     }
     pclose(in);
-    str = str_buf;
     if (str.empty()) {
       throw std::runtime_error("Socket path is empty");
     }
@@ -63,12 +164,11 @@ const std::string Ipc::getSocketPath() const {
   return str;
 }
 
-int Ipc::open(const std::string& socketPath) const {
-  int32_t fd = socket(AF_UNIX, SOCK_STREAM, 0);
+int IpcHub::open(const std::string& socketPath) {
+  int32_t fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
   if (fd == -1) {
     throw std::runtime_error("Unable to open Unix socket");
   }
-  (void)fcntl(fd, F_SETFD, FD_CLOEXEC);
   struct sockaddr_un addr;
   memset(&addr, 0, sizeof(struct sockaddr_un));
   addr.sun_family = AF_UNIX;
@@ -76,82 +176,232 @@ int Ipc::open(const std::string& socketPath) const {
   addr.sun_path[sizeof(addr.sun_path) - 1] = 0;
   int l = sizeof(struct sockaddr_un);
   if (::connect(fd, reinterpret_cast<struct sockaddr*>(&addr), l) == -1) {
+    close(fd);
     throw std::runtime_error("Unable to connect to Sway");
   }
   return fd;
 }
 
-struct Ipc::ipc_response Ipc::recv(int fd) {
-  std::string header;
-  header.resize(ipc_header_size_);
-  auto data32 = reinterpret_cast<uint32_t*>(header.data() + ipc_magic_.size());
-  size_t total = 0;
+void IpcHub::send(int fd, uint32_t type, const std::string& payload) {
+  std::string message(ipc_header_size, '\0');
+  auto data32 = reinterpret_cast<uint32_t*>(message.data() + ipc_magic.size());
+  memcpy(message.data(), ipc_magic.data(), ipc_magic.size());
+  data32[0] = payload.size();
+  data32[1] = type;
+  message.append(payload);
 
-  while (total < ipc_header_size_) {
-    auto res = ::recv(fd, header.data() + total, ipc_header_size_ - total, 0);
-    if (fd_event_ == -1 || fd_ == -1) {
-      // IPC is closed so just return an empty response
-      return {0, 0, ""};
-    }
-    if (res <= 0) {
-      throw std::runtime_error("Unable to receive IPC header");
+  size_t total = 0;
+  while (total < message.size()) {
+    auto res = ::send(fd, message.data() + total, message.size() - total, MSG_NOSIGNAL);
+    if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw std::runtime_error("Unable to send IPC message");
     }
     total += res;
   }
-  auto magic = std::string(header.data(), header.data() + ipc_magic_.size());
-  if (magic != ipc_magic_) {
+}
+
+Ipc::ipc_response IpcHub::recv(int fd) {
+  auto recvAll = [fd](char* data, size_t size, const char* what) {
+    size_t total = 0;
+    while (total < size) {
+      auto res = ::recv(fd, data + total, size - total, 0);
+      if (res == -1 && errno == EINTR) {
+        continue;
+      }
+      if (res <= 0) {
+        throw std::runtime_error(what);
+      }
+      total += res;
+    }
+  };
+
+  char header[ipc_header_size];
+  recvAll(header, ipc_header_size, "Unable to receive IPC header");
+  if (std::string_view(header, ipc_magic.size()) != ipc_magic) {
     throw std::runtime_error("Invalid IPC magic");
   }
+  uint32_t data32[2];
+  memcpy(data32, header + ipc_magic.size(), sizeof(data32));
 
-  total = 0;
-  std::string payload;
-  payload.resize(data32[0]);
-  while (total < data32[0]) {
-    auto res = ::recv(fd, payload.data() + total, data32[0] - total, 0);
-    if (res < 0) {
-      if (errno == EINTR || errno == EAGAIN) {
-        continue;
+  std::string payload(data32[0], '\0');
+  recvAll(payload.data(), payload.size(), "Unable to receive IPC payload");
+  return {data32[0], data32[1], std::move(payload)};
+}
+
+std::string IpcHub::subscribePayload(uint32_t events) {
+  std::string payload = "[";
+  for (const auto& [name, type] : event_types) {
+    if ((events & event_mask(type)) != 0) {
+      payload.append(payload.size() > 1 ? ",\"" : "\"").append(name).append("\"");
+    }
+  }
+  return payload.append("]");
+}
+
+Ipc::ipc_response IpcHub::request(uint32_t type, const std::string& payload) {
+  std::lock_guard<std::mutex> lock(cmdMutex_);
+  if (fd_ == -1) {
+    fd_ = open(socketPath_);
+  }
+  try {
+    send(fd_, type, payload);
+    return recv(fd_);
+  } catch (...) {
+    // Don't reuse a socket that may be out of sync, reconnect on the next request
+    close(fd_);
+    fd_ = -1;
+    throw;
+  }
+}
+
+void IpcHub::subscribe(Ipc* ipc, uint32_t events) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = std::find_if(clients_.begin(), clients_.end(),
+                         [ipc](const auto& client) { return client->ipc == ipc; });
+  if (it == clients_.end()) {
+    it = clients_.insert(clients_.end(), std::make_shared<Client>());
+    (*it)->ipc = ipc;
+  }
+  (*it)->events |= events;
+  // Only new event types need to be added to the subscription of the shared socket. The reply
+  // is read and checked by the reader thread, which also resubscribes after a reconnect.
+  if (const auto added = events & ~events_; added != 0) {
+    events_ |= added;
+    try {
+      send(fd_event_, IPC_SUBSCRIBE, subscribePayload(added));
+    } catch (const std::exception& e) {
+      spdlog::error("sway ipc: {}", e.what());
+    }
+  }
+}
+
+void IpcHub::remove(Ipc* ipc) {
+  std::shared_ptr<Client> client;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto it = std::find_if(clients_.begin(), clients_.end(),
+                           [ipc](const auto& client) { return client->ipc == ipc; });
+    if (it == clients_.end()) {
+      return;
+    }
+    client = std::move(*it);
+    clients_.erase(it);
+  }
+  // Waits for an event being emitted to the client
+  std::lock_guard<std::mutex> lock(client->mutex);
+  client->ipc = nullptr;
+}
+
+void IpcHub::reconnect() {
+  int fd = -1;
+  try {
+    fd = open(socketPath_);
+  } catch (const std::exception& e) {
+    spdlog::debug("sway ipc: {}", e.what());
+    return;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!running_) {
+    close(fd);
+    return;
+  }
+  close(fd_event_);
+  fd_event_ = fd;
+  if (events_ != 0) {
+    try {
+      send(fd_event_, IPC_SUBSCRIBE, subscribePayload(events_));
+    } catch (const std::exception& e) {
+      spdlog::error("sway ipc: {}", e.what());
+    }
+  }
+}
+
+void IpcHub::run() {
+  auto delay = kReconnectMin;
+  while (running_) {
+    Ipc::ipc_response res;
+    try {
+      res = recv(fd_event_);
+    } catch (const std::exception& e) {
+      if (!running_) {
+        break;
       }
-      throw std::runtime_error("Unable to receive IPC payload");
+      spdlog::error("sway ipc: {}, reconnecting in {}ms", e.what(), delay.count());
+      std::this_thread::sleep_for(delay);
+      delay = std::min(delay * 2, kReconnectMax);
+      reconnect();
+      continue;
     }
-    total += res;
+    delay = kReconnectMin;
+
+    if ((res.type & ipc_event_flag) == 0) {
+      // Reply to one of our subscriptions
+      if (res.type == IPC_SUBSCRIBE && res.payload.find("true") == std::string::npos) {
+        spdlog::error("sway ipc: unable to subscribe to events: {}", res.payload);
+      }
+      continue;
+    }
+    dispatch(res);
   }
-  return {data32[0], data32[1], &payload.front()};
 }
 
-struct Ipc::ipc_response Ipc::send(int fd, uint32_t type, const std::string& payload) {
-  std::string header;
-  header.resize(ipc_header_size_);
-  auto data32 = reinterpret_cast<uint32_t*>(header.data() + ipc_magic_.size());
-  memcpy(header.data(), ipc_magic_.c_str(), ipc_magic_.size());
-  data32[0] = payload.size();
-  data32[1] = type;
+void IpcHub::dispatch(const Ipc::ipc_response& res) {
+  Json::Value payload;
+  try {
+    payload = parser_.parse(res.payload);
+  } catch (const std::exception& e) {
+    spdlog::error("sway ipc: {}", e.what());
+    return;
+  }
 
-  if (::send(fd, header.data(), ipc_header_size_, 0) == -1) {
-    throw std::runtime_error("Unable to send IPC header");
+  // Handlers may send commands and subscribe, which needs the hub, so they run unlocked
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& client : clients_) {
+      if ((client->events & event_mask(res.type)) != 0) {
+        dispatching_.push_back(client);
+      }
+    }
   }
-  if (::send(fd, payload.c_str(), payload.size(), 0) == -1) {
-    throw std::runtime_error("Unable to send IPC payload");
+  for (const auto& client : dispatching_) {
+    std::lock_guard<std::mutex> lock(client->mutex);
+    if (client->ipc == nullptr) {
+      // Removed meanwhile
+      continue;
+    }
+    try {
+      client->ipc->signal_event.emit(res.type, payload);
+    } catch (const std::exception& e) {
+      spdlog::error("sway ipc: {}", e.what());
+    }
   }
-  return Ipc::recv(fd);
+  dispatching_.clear();
 }
 
+Ipc::Ipc() : hub_(IpcHub::inst()) {}
+
+Ipc::~Ipc() { hub_->remove(this); }
+
 void Ipc::sendCmd(uint32_t type, const std::string& payload) {
-  std::lock_guard<std::mutex> lock(mutex_);
-  const auto res = Ipc::send(fd_, type, payload);
+  const auto res = hub_->request(type, payload);
   signal_cmd.emit(res);
 }
 
 void Ipc::subscribe(const std::string& payload) {
-  auto res = Ipc::send(fd_event_, IPC_SUBSCRIBE, payload);
-  if (res.payload != "{\"success\": true}") {
-    throw std::runtime_error("Unable to subscribe ipc event");
+  uint32_t events = 0;
+  for (const auto& name : util::JsonParser().parse(payload)) {
+    auto it = std::find_if(std::begin(event_types), std::end(event_types),
+                           [&name](const auto& type) { return type.first == name.asString(); });
+    if (it == std::end(event_types)) {
+      throw std::runtime_error("Unknown sway ipc event " + name.asString());
+    }
+    events |= event_mask(it->second);
   }
-}
-
-void Ipc::handleEvent() {
-  const auto res = Ipc::recv(fd_event_);
-  signal_event.emit(res);
+  hub_->subscribe(this, events);
 }
 
 }  // namespace waybar::modules::sway
@@ -6,23 +6,14 @@ namespace waybar::modules::sway {
 
 Mode::Mode(const std::string& id, const Json::Value& config)
     : ALabel(config, "mode", id, "{}", 0, true) {
-  ipc_.subscribe(R"(["mode"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Mode::onEvent));
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("Mode: {}", e.what());
-    }
-  });
+  ipc_.subscribe(R"(["mode"])");
   dp.emit();
 }
 
-void Mode::onEvent(const struct Ipc::ipc_response& res) {
+void Mode::onEvent(uint32_t type, const Json::Value& payload) {
   try {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto payload = parser_.parse(res.payload);
     if (payload["change"] != "default") {
       if (payload["pango_markup"].asBool()) {
         mode_ = payload["change"].asString();
@@ -42,9 +33,9 @@ auto Mode::update() -> void {
   if (mode_.empty()) {
     event_box_.hide();
   } else {
-    label_.set_markup(fmt::format(fmt::runtime(format_), mode_));
+    setMarkup(fmt::format(fmt::runtime(format_), mode_));
     if (tooltipEnabled()) {
-      label_.set_tooltip_text(mode_);
+      setTooltipText(mode_);
     }
     event_box_.show();
   }
@@ -4,7 +4,13 @@
 
 #include <string>
 
+#include "util/json_filter.hpp"
+
 namespace waybar::modules::sway {
+
+// Only the scratchpad windows are read from the tree
+static const util::JsonFilter tree_filter{"nodes", "floating_nodes", "app_id", "name"};
+
 Scratchpad::Scratchpad(const std::string& id, const Json::Value& config)
     : ALabel(config, "scratchpad", id,
              config["format"].isString() ? config["format"].asString() : "{icon} {count}"),
@@ -14,37 +20,29 @@ Scratchpad::Scratchpad(const std::string& id, const Json::Value& config)
       tooltip_enabled_(config_["tooltip"].isBool() ? config_["tooltip"].asBool() : true),
       tooltip_text_(""),
       count_(0) {
-  ipc_.subscribe(R"(["window"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Scratchpad::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Scratchpad::onCmd));
+  ipc_.subscribe(R"(["window"])");
 
   getTree();
-
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("Scratchpad: {}", e.what());
-    }
-  });
 }
 auto Scratchpad::update() -> void {
   if (count_ || show_empty_) {
     event_box_.show();
-    label_.set_markup(
+    setMarkup(
         fmt::format(fmt::runtime(format_),
                     fmt::arg("icon", getIcon(count_, "", config_["format-icons"].size())),
                     fmt::arg("count", count_)));
     if (tooltip_enabled_) {
-      label_.set_tooltip_markup(tooltip_text_);
+      setTooltipMarkup(tooltip_text_);
     }
   } else {
     event_box_.hide();
   }
   if (count_) {
-    label_.get_style_context()->remove_class("empty");
+    setClass("empty", false);
   } else {
-    label_.get_style_context()->add_class("empty");
+    setClass("empty", true);
   }
   ALabel::update();
 }
@@ -60,7 +58,7 @@ auto Scratchpad::getTree() -> void {
 auto Scratchpad::onCmd(const struct Ipc::ipc_response& res) -> void {
   try {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto tree = parser_.parse(res.payload);
+    auto tree = tree_filter.parse(res.payload);
     count_ = tree["nodes"][0]["nodes"][0]["floating_nodes"].size();
     if (tooltip_enabled_) {
       tooltip_text_.clear();
@@ -79,5 +77,5 @@ auto Scratchpad::onCmd(const struct Ipc::ipc_response& res) -> void {
   }
 }
 
-auto Scratchpad::onEvent(const struct Ipc::ipc_response& res) -> void { getTree(); }
+auto Scratchpad::onEvent(uint32_t type, const Json::Value& payload) -> void { getTree(); }
 }  // namespace waybar::modules::sway
\ No newline at end of file
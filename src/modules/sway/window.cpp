@@ -12,34 +12,67 @@
 #include <string>
 
 #include "util/gtk_icon.hpp"
+#include "util/json_filter.hpp"
 #include "util/rewrite_string.hpp"
 
 namespace waybar::modules::sway {
 
+// Members of the tree nodes read by getFocusedNode(), everything else is skipped while parsing
+static const util::JsonFilter tree_filter{"id",
+                                          "type",
+                                          "name",
+                                          "focused",
+                                          "layout",
+                                          "output",
+                                          "app_id",
+                                          "shell",
+                                          "window_properties",
+                                          "instance",
+                                          "class",
+                                          "nodes",
+                                          "floating_nodes",
+                                          "current_workspace"};
+
+std::tuple<std::string, std::string, std::string> getWindowInfo(const Json::Value& node);
+
 Window::Window(const std::string& id, const Bar& bar, const Json::Value& config)
-    : AAppIconLabel(config, "window", id, "{}", 0, true), bar_(bar), windowId_(-1) {
-  ipc_.subscribe(R"(["window","workspace"])");
+    : AAppIconLabel(config, "window", id, "{}", 0, true),
+      bar_(bar),
+      windowId_(-1),
+      rewrite_(config["rewrite"]) {
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Window::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Window::onCmd));
+  ipc_.subscribe(R"(["window","workspace"])");
   // Get Initial focused window
   getTree();
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception& e) {
-      spdlog::error("Window: {}", e.what());
-      spdlog::trace("Window::Window exception");
-    }
-  });
 }
 
-void Window::onEvent(const struct Ipc::ipc_response& res) { getTree(); }
+void Window::onEvent(uint32_t type, const Json::Value& payload) {
+  if (type == IPC_EVENT_WINDOW) {
+    const auto change = payload["change"].asString();
+    if (change == "mark" || change == "urgent") {
+      return;
+    }
+    if (change == "title") {
+      // A title change doesn't move anything in the tree, so the container is all we need
+      const auto& container = payload["container"];
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (container["id"].asInt() == windowId_) {
+        window_ = Glib::Markup::escape_text(container["name"].asString());
+        std::tie(app_id_, app_class_, shell_) = getWindowInfo(container);
+        updateAppIconName(app_id_, app_class_);
+        dp.emit();
+      }
+      return;
+    }
+  }
+  getTree();
+}
 
 void Window::onCmd(const struct Ipc::ipc_response& res) {
   try {
     std::lock_guard<std::mutex> lock(mutex_);
-    auto payload = parser_.parse(res.payload);
+    auto payload = tree_filter.parse(res.payload);
     auto output = payload["output"].isString() ? payload["output"].asString() : "";
     std::tie(app_nb_, floating_count_, windowId_, window_, app_id_, app_class_, shell_, layout_) =
         getFocusedNode(payload["nodes"], output);
@@ -94,12 +127,10 @@ auto Window::update() -> void {
     old_app_id_ = app_id_;
   }
 
-  label_.set_markup(waybar::util::rewriteString(
-      fmt::format(fmt::runtime(format_), fmt::arg("title", window_), fmt::arg("app_id", app_id_),
-                  fmt::arg("shell", shell_)),
-      config_["rewrite"]));
+  setMarkup(rewrite_.apply(fmt::format(fmt::runtime(format_), fmt::arg("title", window_),
+                                       fmt::arg("app_id", app_id_), fmt::arg("shell", shell_))));
   if (tooltipEnabled()) {
-    label_.set_tooltip_text(window_);
+    setTooltipText(window_);
   }
 
   updateAppIcon();
@@ -5,6 +5,7 @@
 #include <algorithm>
 #include <cctype>
 #include <string>
+#include <unordered_set>
 
 namespace waybar::modules::sway {
 
@@ -33,158 +34,228 @@ Workspaces::Workspaces(const std::string &id, const Bar &bar, const Json::Value
       high_priority_named_.push_back(it.asString());
     }
   }
+  if (config_["persistent_workspaces"].isObject()) {
+    spdlog::warn(
+        "persistent_workspaces is deprecated. Please change config to use "
+        "persistent-workspaces.");
+  }
   box_.set_name("workspaces");
   if (!id.empty()) {
     box_.get_style_context()->add_class(id);
   }
   event_box_.add(box_);
-  ipc_.subscribe(R"(["workspace"])");
   ipc_.signal_event.connect(sigc::mem_fun(*this, &Workspaces::onEvent));
   ipc_.signal_cmd.connect(sigc::mem_fun(*this, &Workspaces::onCmd));
+  ipc_.subscribe(R"(["workspace"])");
   ipc_.sendCmd(IPC_GET_WORKSPACES);
   if (config["enable-bar-scroll"].asBool()) {
     auto &window = const_cast<Bar &>(bar_).window;
     window.add_events(Gdk::SCROLL_MASK | Gdk::SMOOTH_SCROLL_MASK);
     window.signal_scroll_event().connect(sigc::mem_fun(*this, &Workspaces::handleScroll));
   }
-  // Launch worker
-  ipc_.setWorker([this] {
-    try {
-      ipc_.handleEvent();
-    } catch (const std::exception &e) {
-      spdlog::error("Workspaces: {}", e.what());
-    }
-  });
 }
 
-void Workspaces::onEvent(const struct Ipc::ipc_response &res) {
+void Workspaces::onEvent(uint32_t type, const Json::Value &payload) {
   try {
-    ipc_.sendCmd(IPC_GET_WORKSPACES);
+    bool applied = false;
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      applied = applyEvent(payload);
+      if (applied) {
+        rebuildWorkspaces();
+      }
+    }
+    if (applied) {
+      dp.emit();
+    } else {
+      ipc_.sendCmd(IPC_GET_WORKSPACES);
+    }
   } catch (const std::exception &e) {
     spdlog::error("Workspaces: {}", e.what());
   }
 }
 
+// Apply a workspace event to the model. Returns false if a full fetch is required.
+bool Workspaces::applyEvent(const Json::Value &event) {
+  const auto change = event["change"].asString();
+  const auto &current = event["current"];
+  if (change == "reload" || !current.isObject() || sway_workspaces_.empty()) {
+    return false;
+  }
+
+  auto it = std::find_if(sway_workspaces_.begin(), sway_workspaces_.end(),
+                         [&current](const auto &node) { return node["id"] == current["id"]; });
+
+  if (change == "init") {
+    if (it != sway_workspaces_.end()) {
+      return false;
+    }
+    // event nodes contain the whole subtree, only keep what GET_WORKSPACES would report
+    Json::Value v;
+    v["id"] = current["id"];
+    v["name"] = current["name"];
+    v["num"] = current["num"];
+    v["output"] = current["output"];
+    v["urgent"] = current["urgent"];
+    v["focused"] = false;
+    v["visible"] = false;
+    sway_workspaces_.emplace_back(std::move(v));
+  } else if (change == "empty") {
+    if (it == sway_workspaces_.end()) {
+      return false;
+    }
+    sway_workspaces_.erase(it);
+  } else if (change == "focus") {
+    if (it == sway_workspaces_.end()) {
+      return false;
+    }
+    const auto output = (*it)["output"];
+    for (auto &node : sway_workspaces_) {
+      const bool is_current = node["id"] == current["id"];
+      node["focused"] = is_current;
+      // a single workspace is visible per output
+      if (node["output"] == output) {
+        node["visible"] = is_current;
+      }
+    }
+  } else if (change == "rename") {
+    if (it == sway_workspaces_.end()) {
+      return false;
+    }
+    (*it)["name"] = current["name"];
+    (*it)["num"] = current["num"];
+  } else if (change == "urgent") {
+    if (it == sway_workspaces_.end()) {
+      return false;
+    }
+    (*it)["urgent"] = current["urgent"];
+  } else {
+    // "move" changes the visible workspace of two outputs, refetch
+    return false;
+  }
+  return true;
+}
+
 void Workspaces::onCmd(const struct Ipc::ipc_response &res) {
   if (res.type == IPC_GET_WORKSPACES) {
     try {
       {
         std::lock_guard<std::mutex> lock(mutex_);
         auto payload = parser_.parse(res.payload);
-        workspaces_.clear();
-        std::copy_if(payload.begin(), payload.end(), std::back_inserter(workspaces_),
-                     [&](const auto &workspace) {
-                       return !config_["all-outputs"].asBool()
-                                  ? workspace["output"].asString() == bar_.output->name
-                                  : true;
-                     });
+        sway_workspaces_.assign(payload.begin(), payload.end());
+        rebuildWorkspaces();
+      }
+      dp.emit();
+    } catch (const std::exception &e) {
+      spdlog::error("Workspaces: {}", e.what());
+    }
+  }
+}
 
-        if (config_["persistent_workspaces"].isObject()) {
-          spdlog::warn(
-              "persistent_workspaces is deprecated. Please change config to use "
-              "persistent-workspaces.");
-        }
+void Workspaces::rebuildWorkspaces() {
+  workspaces_.clear();
+  std::copy_if(sway_workspaces_.begin(), sway_workspaces_.end(), std::back_inserter(workspaces_),
+               [&](const auto &workspace) {
+                 return !config_["all-outputs"].asBool()
+                            ? workspace["output"].asString() == bar_.output->name
+                            : true;
+               });
 
-        // adding persistent workspaces (as per the config file)
-        if (config_["persistent-workspaces"].isObject() ||
-            config_["persistent_workspaces"].isObject()) {
-          const Json::Value &p_workspaces = config_["persistent-workspaces"].isObject()
-                                                ? config_["persistent-workspaces"]
-                                                : config_["persistent_workspaces"];
-          const std::vector<std::string> p_workspaces_names = p_workspaces.getMemberNames();
+  // adding persistent workspaces (as per the config file)
+  if (config_["persistent-workspaces"].isObject() ||
+      config_["persistent_workspaces"].isObject()) {
+    const Json::Value &p_workspaces = config_["persistent-workspaces"].isObject()
+                                          ? config_["persistent-workspaces"]
+                                          : config_["persistent_workspaces"];
+    const std::vector<std::string> p_workspaces_names = p_workspaces.getMemberNames();
 
-          for (const std::string &p_w_name : p_workspaces_names) {
-            const Json::Value &p_w = p_workspaces[p_w_name];
-            auto it =
-                std::find_if(payload.begin(), payload.end(), [&p_w_name](const Json::Value &node) {
-                  return node["name"].asString() == p_w_name;
-                });
+    std::unordered_set<std::string> existing;
+    for (const auto &node : sway_workspaces_) {
+      existing.insert(node["name"].asString());
+    }
 
-            if (it != payload.end()) {
-              continue;  // already displayed by some bar
-            }
+    for (const std::string &p_w_name : p_workspaces_names) {
+      const Json::Value &p_w = p_workspaces[p_w_name];
 
-            if (p_w.isArray() && !p_w.empty()) {
-              // Adding to target outputs
-              for (const Json::Value &output : p_w) {
-                if (output.asString() == bar_.output->name) {
-                  Json::Value v;
-                  v["name"] = p_w_name;
-                  v["target_output"] = bar_.output->name;
-                  v["num"] = convertWorkspaceNameToNum(p_w_name);
-                  workspaces_.emplace_back(std::move(v));
-                  break;
-                }
-              }
-            } else {
-              // Adding to all outputs
-              Json::Value v;
-              v["name"] = p_w_name;
-              v["target_output"] = "";
-              v["num"] = convertWorkspaceNameToNum(p_w_name);
-              workspaces_.emplace_back(std::move(v));
-            }
-          }
-        }
+      if (existing.contains(p_w_name)) {
+        continue;  // already displayed by some bar
+      }
 
-        // sway has a defined ordering of workspaces that should be preserved in
-        // the representation displayed by waybar to ensure that commands such
-        // as "workspace prev" or "workspace next" make sense when looking at
-        // the workspace representation in the bar.
-        // Due to waybar's own feature of persistent workspaces unknown to sway,
-        // custom sorting logic is necessary to make these workspaces appear
-        // naturally in the list of workspaces without messing up sway's
-        // sorting. For this purpose, a custom numbering property is created
-        // that preserves the order provided by sway while inserting numbered
-        // persistent workspaces at their natural positions.
-        //
-        // All of this code assumes that sway provides numbered workspaces first
-        // and other workspaces are sorted by their creation time.
-        //
-        // In a first pass, the maximum "num" value is computed to enqueue
-        // unnumbered workspaces behind numbered ones when computing the sort
-        // attribute.
-        //
-        // Note: if the 'alphabetical_sort' option is true, the user is in
-        // agreement that the "workspace prev/next" commands may not follow
-        // the order displayed in Waybar.
-        int max_num = -1;
-        for (auto &workspace : workspaces_) {
-          max_num = std::max(workspace["num"].asInt(), max_num);
-        }
-        for (auto &workspace : workspaces_) {
-          auto workspace_num = workspace["num"].asInt();
-          if (workspace_num > -1) {
-            workspace["sort"] = workspace_num;
-          } else {
-            workspace["sort"] = ++max_num;
+      if (p_w.isArray() && !p_w.empty()) {
+        // Adding to target outputs
+        for (const Json::Value &output : p_w) {
+          if (output.asString() == bar_.output->name) {
+            Json::Value v;
+            v["name"] = p_w_name;
+            v["target_output"] = bar_.output->name;
+            v["num"] = convertWorkspaceNameToNum(p_w_name);
+            workspaces_.emplace_back(std::move(v));
+            break;
           }
         }
-        std::sort(workspaces_.begin(), workspaces_.end(),
-                  [this](const Json::Value &lhs, const Json::Value &rhs) {
-                    auto lname = lhs["name"].asString();
-                    auto rname = rhs["name"].asString();
-                    int l = lhs["sort"].asInt();
-                    int r = rhs["sort"].asInt();
-
-                    if (l == r || config_["alphabetical_sort"].asBool()) {
-                      // In case both integers are the same, lexicographical
-                      // sort. The code above already ensure that this will only
-                      // happened in case of explicitly numbered workspaces.
-                      //
-                      // Additionally, if the config specifies to sort workspaces
-                      // alphabetically do this here.
-                      return lname < rname;
-                    }
-
-                    return l < r;
-                  });
+      } else {
+        // Adding to all outputs
+        Json::Value v;
+        v["name"] = p_w_name;
+        v["target_output"] = "";
+        v["num"] = convertWorkspaceNameToNum(p_w_name);
+        workspaces_.emplace_back(std::move(v));
       }
-      dp.emit();
-    } catch (const std::exception &e) {
-      spdlog::error("Workspaces: {}", e.what());
     }
   }
+
+  // sway has a defined ordering of workspaces that should be preserved in
+  // the representation displayed by waybar to ensure that commands such
+  // as "workspace prev" or "workspace next" make sense when looking at
+  // the workspace representation in the bar.
+  // Due to waybar's own feature of persistent workspaces unknown to sway,
+  // custom sorting logic is necessary to make these workspaces appear
+  // naturally in the list of workspaces without messing up sway's
+  // sorting. For this purpose, a custom numbering property is created
+  // that preserves the order provided by sway while inserting numbered
+  // persistent workspaces at their natural positions.
+  //
+  // All of this code assumes that sway provides numbered workspaces first
+  // and other workspaces are sorted by their creation time.
+  //
+  // In a first pass, the maximum "num" value is computed to enqueue
+  // unnumbered workspaces behind numbered ones when computing the sort
+  // attribute.
+  //
+  // Note: if the 'alphabetical_sort' option is true, the user is in
+  // agreement that the "workspace prev/next" commands may not follow
+  // the order displayed in Waybar.
+  int max_num = -1;
+  for (auto &workspace : workspaces_) {
+    max_num = std::max(workspace["num"].asInt(), max_num);
+  }
+  for (auto &workspace : workspaces_) {
+    auto workspace_num = workspace["num"].asInt();
+    if (workspace_num > -1) {
+      workspace["sort"] = workspace_num;
+    } else {
+      workspace["sort"] = ++max_num;
+    }
+  }
+  std::sort(workspaces_.begin(), workspaces_.end(),
+            [this](const Json::Value &lhs, const Json::Value &rhs) {
+              auto lname = lhs["name"].asString();
+              auto rname = rhs["name"].asString();
+              int l = lhs["sort"].asInt();
+              int r = rhs["sort"].asInt();
+
+              if (l == r || config_["alphabetical_sort"].asBool()) {
+                // In case both integers are the same, lexicographical
+                // sort. The code above already ensure that this will only
+                // happened in case of explicitly numbered workspaces.
+                //
+                // Additionally, if the config specifies to sort workspaces
+                // alphabetically do this here.
+                return lname < rname;
+              }
+
+              return l < r;
+            });
 }
 
 bool Workspaces::filterButtons() {
@@ -2,12 +2,15 @@
 
 #include <filesystem>
 
+#include "util/proc_file.hpp"
+
 #if defined(__FreeBSD__)
 #include <sys/sysctl.h>
 #endif
 
 waybar::modules::Temperature::Temperature(const std::string& id, const Json::Value& config)
-    : ALabel(config, "temperature", id, "{temperatureC}°C", 10) {
+    : ALabel(config, "temperature", id, "{temperatureC}°C", 10),
+      history_(util::graphLength(config)) {
 #if defined(__FreeBSD__)
 // try to read sysctl?
 #else
@@ -32,19 +35,18 @@ waybar::modules::Temperature::Temperature(const std::string& id, const Json::Val
     auto zone = config_["thermal-zone"].isInt() ? config_["thermal-zone"].asInt() : 0;
     file_path_ = fmt::format("/sys/class/thermal/thermal_zone{}/temp", zone);
   }
-  std::ifstream temp(file_path_);
-  if (!temp.is_open()) {
-    throw std::runtime_error("Can't open " + file_path_);
-  }
 #endif
-  thread_ = [this] {
+  // Bars on several outputs share one reader per sensor. Throws if the sensor can't be read.
+  auto sampler =
+      util::Sampler<float>::get("temperature:" + file_path_, [this] { return makeReader(); });
+  sampler_ = sampler->subscribe(interval_, [this] {
+    new_sample_ = true;
     dp.emit();
-    thread_.sleep_for(interval_);
-  };
+  });
 }
 
 auto waybar::modules::Temperature::update() -> void {
-  auto temperature = getTemperature();
+  auto temperature = *sampler_.latest();
   uint16_t temperature_c = std::round(temperature);
   uint16_t temperature_f = std::round(temperature * 1.8 + 32);
   uint16_t temperature_k = std::round(temperature + 273.15);
@@ -52,10 +54,8 @@ auto waybar::modules::Temperature::update() -> void {
   auto format = format_;
   if (critical) {
     format = config_["format-critical"].isString() ? config_["format-critical"].asString() : format;
-    label_.get_style_context()->add_class("critical");
-  } else {
-    label_.get_style_context()->remove_class("critical");
   }
+  setClass("critical", critical);
 
   if (format.empty()) {
     event_box_.hide();
@@ -65,50 +65,48 @@ auto waybar::modules::Temperature::update() -> void {
   }
 
   auto max_temp = config_["critical-threshold"].isInt() ? config_["critical-threshold"].asInt() : 0;
-  label_.set_markup(fmt::format(fmt::runtime(format), fmt::arg("temperatureC", temperature_c),
-                                fmt::arg("temperatureF", temperature_f),
-                                fmt::arg("temperatureK", temperature_k),
-                                fmt::arg("icon", getIcon(temperature_c, "", max_temp))));
+  if (new_sample_.exchange(false)) {
+    history_.push(temperature);
+  }
+  // Scaled in °C up to the critical threshold, so that the graph doesn't amplify small changes
+  const auto graph = history_.sparkline(0, std::max<float>(max_temp, history_.max()));
+  setMarkup(fmt::format(fmt::runtime(format), fmt::arg("temperatureC", temperature_c),
+                        fmt::arg("temperatureF", temperature_f),
+                        fmt::arg("temperatureK", temperature_k),
+                        fmt::arg("temperatureGraph", graph),
+                        fmt::arg("icon", getIcon(temperature_c, "", max_temp))));
   if (tooltipEnabled()) {
     std::string tooltip_format = "{temperatureC}°C";
     if (config_["tooltip-format"].isString()) {
       tooltip_format = config_["tooltip-format"].asString();
     }
-    label_.set_tooltip_text(fmt::format(
+    setTooltipText(fmt::format(
         fmt::runtime(tooltip_format), fmt::arg("temperatureC", temperature_c),
-        fmt::arg("temperatureF", temperature_f), fmt::arg("temperatureK", temperature_k)));
+        fmt::arg("temperatureF", temperature_f), fmt::arg("temperatureK", temperature_k),
+        fmt::arg("temperatureGraph", graph)));
   }
   // Call parent update
   ALabel::update();
 }
 
-float waybar::modules::Temperature::getTemperature() {
+waybar::util::Sampler<float>::Reader waybar::modules::Temperature::makeReader() {
 #if defined(__FreeBSD__)
-  int temp;
-  size_t size = sizeof temp;
-
-  auto zone = config_["thermal-zone"].isInt() ? config_["thermal-zone"].asInt() : 0;
-  auto sysctl_thermal = fmt::format("hw.acpi.thermal.tz{}.temperature", zone);
+  return [](float& temperature_c) {
+    int temp;
+    size_t size = sizeof temp;
 
-  if (sysctlbyname("hw.acpi.thermal.tz0.temperature", &temp, &size, NULL, 0) != 0) {
-    throw std::runtime_error(
-        "sysctl hw.acpi.thermal.tz0.temperature or dev.cpu.0.temperature failed");
-  }
-  auto temperature_c = ((float)temp - 2732) / 10;
-  return temperature_c;
+    if (sysctlbyname("hw.acpi.thermal.tz0.temperature", &temp, &size, NULL, 0) != 0) {
+      throw std::runtime_error(
+          "sysctl hw.acpi.thermal.tz0.temperature or dev.cpu.0.temperature failed");
+    }
+    temperature_c = ((float)temp - 2732) / 10;
+  };
 
 #else  // Linux
-  std::ifstream temp(file_path_);
-  if (!temp.is_open()) {
-    throw std::runtime_error("Can't open " + file_path_);
-  }
-  std::string line;
-  if (temp.good()) {
-    getline(temp, line);
-  }
-  temp.close();
-  auto temperature_c = std::strtol(line.c_str(), nullptr, 10) / 1000.0;
-  return temperature_c;
+  return [file = std::make_shared<util::ProcFile>(file_path_)](float& temperature_c) {
+    const std::string line(file->read());
+    temperature_c = std::strtol(line.c_str(), nullptr, 10) / 1000.0;
+  };
 #endif
 }
 
@@ -75,12 +75,8 @@ std::string User::get_user_login() const { return Glib::get_user_name(); }
 std::string User::get_user_home_dir() const { return Glib::get_home_dir(); }
 
 void User::init_update_worker() {
-  this->thread_ = [this] {
-    ALabel::dp.emit();
-    auto now = std::chrono::system_clock::now();
-    auto diff = now.time_since_epoch() % ALabel::interval_;
-    this->thread_.sleep_for(ALabel::interval_ - diff);
-  };
+  this->timer_ = util::Scheduler::inst().every(
+      ALabel::interval_, [this] { ALabel::dp.emit(); }, true);
 }
 
 void User::init_avatar(const Json::Value& config) {
@@ -137,7 +133,7 @@ auto User::update() -> void {
       fmt::arg("work_M", fmt::format("{:%M}", workSystemTimeSeconds)),
       fmt::arg("work_S", fmt::format("{:%S}", workSystemTimeSeconds)),
       fmt::arg("user", systemUser));
-  ALabel::label_.set_markup(label);
+  setMarkup(label);
   AIconLabel::update();
 }
 };  // namespace waybar::modules
@@ -278,15 +278,15 @@ auto waybar::modules::Wireplumber::update() -> void {
 
   if (muted_) {
     format = config_["format-muted"].isString() ? config_["format-muted"].asString() : format;
-    label_.get_style_context()->add_class("muted");
+    setClass("muted", true);
   } else {
-    label_.get_style_context()->remove_class("muted");
+    setClass("muted", false);
   }
 
   int vol = round(volume_ * 100.0);
   std::string markup = fmt::format(fmt::runtime(format), fmt::arg("node_name", node_name_),
                                    fmt::arg("volume", vol), fmt::arg("icon", getIcon(vol)));
-  label_.set_markup(markup);
+  setMarkup(markup);
 
   getState(vol);
 
@@ -296,11 +296,11 @@ auto waybar::modules::Wireplumber::update() -> void {
     }
 
     if (!tooltip_format.empty()) {
-      label_.set_tooltip_text(fmt::format(fmt::runtime(tooltip_format),
-                                          fmt::arg("node_name", node_name_),
-                                          fmt::arg("volume", vol), fmt::arg("icon", getIcon(vol))));
+      setTooltipText(fmt::format(fmt::runtime(tooltip_format),
+                                 fmt::arg("node_name", node_name_),
+                                 fmt::arg("volume", vol), fmt::arg("icon", getIcon(vol))));
     } else {
-      label_.set_tooltip_text(node_name_);
+      setTooltipText(node_name_);
     }
   }
 
@@ -20,6 +20,7 @@
 #include "glibmm/fileutils.h"
 #include "glibmm/refptr.h"
 #include "util/format.hpp"
+#include "util/gtk_icon.hpp"
 #include "util/rewrite_string.hpp"
 #include "util/string.hpp"
 
@@ -54,15 +55,6 @@ static std::vector<std::string> search_prefix() {
   return prefixes;
 }
 
-static Glib::RefPtr<Gdk::Pixbuf> load_icon_from_file(std::string icon_path, int size) {
-  try {
-    auto pb = Gdk::Pixbuf::create_from_file(icon_path, size, size);
-    return pb;
-  } catch (...) {
-    return {};
-  }
-}
-
 static Glib::RefPtr<Gio::DesktopAppInfo> get_app_info_by_name(const std::string &app_id) {
   static std::vector<std::string> prefixes = search_prefix();
 
@@ -177,25 +169,9 @@ bool Task::image_load_icon(Gtk::Image &image, const Glib::RefPtr<Gtk::IconTheme>
     }
   }
 
-  Glib::RefPtr<Gdk::Pixbuf> pixbuf;
-  auto scaled_icon_size = size * image.get_scale_factor();
-
-  try {
-    pixbuf = icon_theme->load_icon(ret_icon_name, scaled_icon_size, Gtk::ICON_LOOKUP_FORCE_SIZE);
-  } catch (...) {
-    if (Glib::file_test(ret_icon_name, Glib::FILE_TEST_EXISTS))
-      pixbuf = load_icon_from_file(ret_icon_name, scaled_icon_size);
-    else
-      pixbuf = {};
-  }
-
-  if (pixbuf) {
-    if (pixbuf->get_width() != scaled_icon_size) {
-      int width = scaled_icon_size * pixbuf->get_width() / pixbuf->get_height();
-      pixbuf = pixbuf->scale_simple(width, scaled_icon_size, Gdk::InterpType::INTERP_BILINEAR);
-    }
-    auto surface = Gdk::Cairo::create_surface_from_pixbuf(pixbuf, image.get_scale_factor(),
-                                                          image.get_window());
+  auto scale = image.get_scale_factor();
+  auto surface = util::IconCache::inst().load(icon_theme, ret_icon_name, size * scale, scale);
+  if (surface) {
     image.set(surface);
     return true;
   }
@@ -624,7 +600,7 @@ void Task::update() {
                     fmt::arg("app_id", app_id), fmt::arg("state", state_string()),
                     fmt::arg("short_state", state_string(true)));
 
-    txt = waybar::util::rewriteString(txt, config_["rewrite"]);
+    txt = tbar_->rewrite_rules().apply(txt);
 
     if (markup)
       text_before_.set_markup(txt);
@@ -638,7 +614,7 @@ void Task::update() {
                     fmt::arg("app_id", app_id), fmt::arg("state", state_string()),
                     fmt::arg("short_state", state_string(true)));
 
-    txt = waybar::util::rewriteString(txt, config_["rewrite"]);
+    txt = tbar_->rewrite_rules().apply(txt);
 
     if (markup)
       text_after_.set_markup(txt);
@@ -711,6 +687,7 @@ Taskbar::Taskbar(const std::string &id, const waybar::Bar &bar, const Json::Valu
     : waybar::AModule(config, "taskbar", id, false, false),
       bar_(bar),
       box_{bar.vertical ? Gtk::ORIENTATION_VERTICAL : Gtk::ORIENTATION_HORIZONTAL, 0},
+      rewrite_rules_{config["rewrite"]},
       manager_{nullptr},
       seat_{nullptr} {
   box_.set_name("taskbar");
@@ -740,20 +717,16 @@ Taskbar::Taskbar(const std::string &id, const waybar::Bar &bar, const Json::Valu
     for (auto &c : config_["icon-theme"]) {
       auto it_name = c.asString();
 
-      auto it = Gtk::IconTheme::create();
-      it->set_custom_theme(it_name);
       spdlog::debug("Use custom icon theme: {}", it_name);
 
-      icon_themes_.push_back(it);
+      icon_themes_.push_back(util::IconCache::inst().theme(it_name));
     }
   } else if (config_["icon-theme"].isString()) {
     auto it_name = config_["icon-theme"].asString();
 
-    auto it = Gtk::IconTheme::create();
-    it->set_custom_theme(it_name);
     spdlog::debug("Use custom icon theme: {}", it_name);
 
-    icon_themes_.push_back(it);
+    icon_themes_.push_back(util::IconCache::inst().theme(it_name));
   }
 
   // Load ignore-list
@@ -914,4 +887,6 @@ const std::map<std::string, std::string> &Taskbar::app_ids_replace_map() const {
   return app_ids_replace_map_;
 }
 
+const util::RewriteRules &Taskbar::rewrite_rules() const { return rewrite_rules_; }
+
 } /* namespace waybar::modules::wlr */
@@ -0,0 +1,147 @@
+#include "util/event_queue.hpp"
+
+#include <spdlog/spdlog.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace waybar::util {
+
+namespace {
+
+// Events run per wakeup, so that a flood of events doesn't starve the rest of the main loop
+constexpr int kMaxEventsPerDispatch = 256;
+
+}  // namespace
+
+EventQueue& EventQueue::inst() {
+  static EventQueue queue;
+  return queue;
+}
+
+EventQueue::EventQueue() : head_(&stub_), tail_(&stub_) {
+  fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (fd_ == -1) {
+    throw std::runtime_error(std::string("Can't create the event queue eventfd: ") +
+                             strerror(errno));
+  }
+  source_ = Glib::signal_io().connect(sigc::mem_fun(*this, &EventQueue::dispatch), fd_,
+                                      Glib::IO_IN);
+}
+
+EventQueue::~EventQueue() {
+  source_.disconnect();
+  close(fd_);
+  while (auto* event = pop()) {
+    delete event;
+  }
+}
+
+void EventQueue::post(std::unique_ptr<Event> event) {
+  push(event.release());
+  if (!signaled_.exchange(true)) {
+    wake();
+  }
+}
+
+void EventQueue::push(Event* event) {
+  event->next_.store(nullptr, std::memory_order_relaxed);
+  auto* prev = head_.exchange(event);
+  prev->next_.store(event, std::memory_order_release);
+}
+
+auto EventQueue::pop() -> Event* {
+  for (;;) {
+    auto* tail = tail_;
+    auto* next = tail->next_.load(std::memory_order_acquire);
+    if (tail == &stub_) {
+      if (next == nullptr) {
+        if (head_.load(std::memory_order_acquire) == &stub_) {
+          return nullptr;
+        }
+        std::this_thread::yield();
+        continue;
+      }
+      tail_ = next;
+      tail = next;
+      next = next->next_.load(std::memory_order_acquire);
+    }
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    if (head_.load(std::memory_order_acquire) != tail) {
+      // A producer swapped head_ but didn't link its event yet
+      std::this_thread::yield();
+      continue;
+    }
+    // tail is the last event, put the stub behind it to be able to take it
+    push(&stub_);
+    next = tail->next_.load(std::memory_order_acquire);
+    if (next != nullptr) {
+      tail_ = next;
+      return tail;
+    }
+    std::this_thread::yield();
+  }
+}
+
+bool EventQueue::dispatch(Glib::IOCondition) {
+  uint64_t count;
+  while (read(fd_, &count, sizeof(count)) == -1 && errno == EINTR) {
+  }
+  // Posts from here on wake the loop again. The fence orders the store before the reads of the
+  // queue, or a post could see the flag still set while we see its event not yet queued.
+  signaled_.store(false);
+  std::atomic_thread_fence(std::memory_order_seq_cst);
+
+  for (int i = 0; i < kMaxEventsPerDispatch; ++i) {
+    std::unique_ptr<Event> event(pop());
+    if (!event) {
+      return true;
+    }
+    try {
+      event->run();
+    } catch (const std::exception& e) {
+      spdlog::error("Event handler failed: {}", e.what());
+    }
+  }
+  // Come back for the rest on the next iteration of the main loop
+  if (!signaled_.exchange(true)) {
+    wake();
+  }
+  return true;
+}
+
+void EventQueue::wake() {
+  const uint64_t one = 1;
+  while (write(fd_, &one, sizeof(one)) == -1 && errno == EINTR) {
+  }
+}
+
+Dispatcher::Dispatcher() : state_(std::make_shared<State>()) {}
+
+Dispatcher::~Dispatcher() {
+  state_->alive.store(false, std::memory_order_release);
+  state_->signal.clear();
+}
+
+void Dispatcher::emit() {
+  if (state_->pending.exchange(true, std::memory_order_acq_rel)) {
+    return;
+  }
+  EventQueue::inst().post([state = state_] {
+    // Emissions from here on need another run
+    state->pending.store(false, std::memory_order_release);
+    if (state->alive.load(std::memory_order_acquire)) {
+      state->signal.emit();
+    }
+  });
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,51 @@
+#include "util/format_template.hpp"
+
+#include <algorithm>
+
+namespace waybar::util {
+
+FormatTemplate::FormatTemplate(std::string_view format) {
+  size_t next_index = 0;
+  size_t pos = 0;
+  while (pos < format.size()) {
+    const auto brace = format.find_first_of("{}", pos);
+    text_.append(format.substr(pos, brace - pos));
+    if (brace == std::string_view::npos) {
+      break;
+    }
+    // Escaped brace
+    if (brace + 1 < format.size() && format[brace + 1] == format[brace]) {
+      text_.push_back(format[brace]);
+      pos = brace + 2;
+      continue;
+    }
+    if (format[brace] == '}') {
+      throw fmt::format_error("unmatched '}' in format string");
+    }
+    const auto end = format.find_first_of("{}", brace + 1);
+    if (end == std::string_view::npos) {
+      throw fmt::format_error("missing '}' in format string");
+    }
+    if (format[end] == '{') {
+      throw fmt::format_error("nested replacement fields are not supported");
+    }
+    auto field = format.substr(brace + 1, end - brace - 1);
+    const auto colon = field.find(':');
+    Field parsed{text_.size(), std::string(field.substr(0, colon)), ""};
+    if (colon != std::string_view::npos) {
+      parsed.spec.append("{").append(field.substr(colon)).append("}");
+    }
+    if (parsed.name.empty()) {
+      parsed.name = std::to_string(next_index++);
+    }
+    fields_.push_back(std::move(parsed));
+    pos = end + 1;
+  }
+}
+
+bool FormatTemplate::references(std::string_view name) const {
+  return std::any_of(fields_.begin(), fields_.end(),
+                     [name](const auto& field) { return field.name == name; });
+}
+
+}  // namespace waybar::util
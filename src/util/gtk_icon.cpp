@@ -1,5 +1,11 @@
 #include "util/gtk_icon.hpp"
 
+#include <fmt/core.h>
+#include <gdkmm/general.h>
+#include <glibmm/fileutils.h>
+#include <glibmm/main.h>
+#include <spdlog/spdlog.h>
+
 /* We need a global mutex for accessing the object returned by Gtk::IconTheme::get_default()
  * because it always returns the same object across different threads, and concurrent
  * access can cause data corruption and lead to invalid memory access and crashes.
@@ -23,3 +29,101 @@ Glib::RefPtr<Gdk::Pixbuf> DefaultGtkIconThemeWrapper::load_icon(const char* name
   default_theme->rescan_if_needed();
   return default_theme->load_icon(name, tmp_size, flags);
 }
+
+namespace waybar::util {
+
+IconCache& IconCache::inst() {
+  static IconCache cache;
+  return cache;
+}
+
+IconCache::IconCache() : cache_(kCacheSize) { watch(Gtk::IconTheme::get_default()); }
+
+IconCache::~IconCache() {
+  spdlog::debug("Icon cache: {} hits, {} misses, {} evictions", cache_.hits(), cache_.misses(),
+                cache_.evictions());
+}
+
+Glib::RefPtr<Gtk::IconTheme> IconCache::theme(const std::string& name) {
+  if (name.empty()) {
+    return Gtk::IconTheme::get_default();
+  }
+  std::lock_guard lock(mutex_);
+  auto& theme = themes_[name];
+  if (!theme) {
+    theme = Gtk::IconTheme::create();
+    theme->set_custom_theme(name);
+    watch(theme);
+  }
+  return theme;
+}
+
+Cairo::RefPtr<Cairo::Surface> IconCache::load(const Glib::RefPtr<Gtk::IconTheme>& theme,
+                                              const std::string& name, int size, int scale) {
+  // Themes live as long as the cache, their address identifies them
+  const auto key =
+      fmt::format("{}:{}:{}:{}", static_cast<void*>(theme->gobj()), size, scale, name);
+  uint64_t generation;
+  {
+    std::lock_guard lock(mutex_);
+    if (const auto* surface = cache_.find(key)) {
+      return *surface;
+    }
+    generation = generation_;
+  }
+
+  // Rendered unlocked, a rescan may emit the changed signal of the theme
+  Glib::RefPtr<Gdk::Pixbuf> pixbuf;
+  try {
+    if (name.find('/') != std::string::npos) {
+      if (Glib::file_test(name, Glib::FILE_TEST_EXISTS)) {
+        pixbuf = Gdk::Pixbuf::create_from_file(name, -1, size);
+      }
+    } else if (theme == Gtk::IconTheme::get_default()) {
+      pixbuf = DefaultGtkIconThemeWrapper::load_icon(name.c_str(), size,
+                                                     Gtk::ICON_LOOKUP_FORCE_SIZE);
+    } else {
+      theme->rescan_if_needed();
+      pixbuf = theme->load_icon(name, size, Gtk::ICON_LOOKUP_FORCE_SIZE);
+    }
+  } catch (const Glib::Error& e) {
+    spdlog::trace("Can't load icon {}: {}", name, static_cast<std::string>(e.what()));
+  }
+
+  Cairo::RefPtr<Cairo::Surface> surface;
+  if (pixbuf) {
+    if (pixbuf->get_height() != size) {
+      int width = size * pixbuf->get_width() / pixbuf->get_height();
+      pixbuf = pixbuf->scale_simple(width, size, Gdk::InterpType::INTERP_BILINEAR);
+    }
+    surface = Gdk::Cairo::create_surface_from_pixbuf(pixbuf, scale, Glib::RefPtr<Gdk::Window>());
+  }
+  std::lock_guard lock(mutex_);
+  // Don't keep what was rendered from a theme that changed meanwhile
+  if (generation != generation_) {
+    return surface;
+  }
+  return cache_.put(key, surface);
+}
+
+auto IconCache::stats() -> Stats {
+  std::lock_guard lock(mutex_);
+  return {cache_.size(), cache_.hits(), cache_.misses(), cache_.evictions()};
+}
+
+void IconCache::watch(const Glib::RefPtr<Gtk::IconTheme>& theme) {
+  theme->signal_changed().connect(sigc::mem_fun(*this, &IconCache::clear));
+}
+
+void IconCache::clear() {
+  {
+    std::lock_guard lock(mutex_);
+    cache_.clear();
+    ++generation_;
+  }
+  spdlog::debug("Icon theme changed, icon cache cleared");
+  // Not right away, themes change in the middle of loading an icon
+  Glib::signal_idle().connect_once([this] { signal_changed_.emit(); });
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,97 @@
+#include "util/history.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <string_view>
+
+namespace waybar::util {
+
+namespace {
+
+constexpr size_t kDefaultGraphLength = 10;
+
+constexpr std::string_view kBlocks[] = {"▁", "▂", "▃", "▄", "▅", "▆", "▇", "█"};
+constexpr int kLevels = sizeof(kBlocks) / sizeof(kBlocks[0]);
+
+}  // namespace
+
+template <typename Dominates>
+void History::MonotonicQueue::push(uint64_t number, const std::vector<float>& values,
+                                   Dominates dominates) {
+  const auto value = values[number % values.size()];
+  // Samples dominated by the new one can't become the extremum before it leaves the window
+  while (size_ > 0 &&
+         dominates(value, values[numbers_[(head_ + size_ - 1) % numbers_.size()] %
+                                 values.size()])) {
+    --size_;
+  }
+  numbers_[(head_ + size_) % numbers_.size()] = number;
+  ++size_;
+}
+
+void History::MonotonicQueue::expire(uint64_t first) {
+  while (size_ > 0 && numbers_[head_] < first) {
+    head_ = (head_ + 1) % numbers_.size();
+    --size_;
+  }
+}
+
+History::History(size_t capacity)
+    : values_(std::max<size_t>(capacity, 1)),
+      alpha_(2.f / (values_.size() + 1)),
+      min_(values_.size()),
+      max_(values_.size()) {}
+
+void History::push(float value) {
+  const auto slot = count_ % values_.size();
+  if (size_ == values_.size()) {
+    sum_ -= values_[slot];
+  } else {
+    ++size_;
+  }
+  values_[slot] = value;
+  sum_ += value;
+  // Don't let rounding errors of the running sum pile up
+  if (slot == values_.size() - 1) {
+    sum_ = std::accumulate(values_.begin(), values_.begin() + size_, 0.0);
+  }
+  ewma_ = count_ == 0 ? value : alpha_ * value + (1 - alpha_) * ewma_;
+
+  const auto first = count_ + 1 - size_;
+  min_.expire(first);
+  max_.expire(first);
+  min_.push(count_, values_, [](float a, float b) { return a <= b; });
+  max_.push(count_, values_, [](float a, float b) { return a >= b; });
+  ++count_;
+}
+
+float History::operator[](size_t i) const { return at(count_ - size_ + i); }
+
+float History::min() const { return min_.empty() ? 0 : at(min_.front()); }
+
+float History::max() const { return max_.empty() ? 0 : at(max_.front()); }
+
+float History::avg() const { return size_ == 0 ? 0 : sum_ / size_; }
+
+std::string History::sparkline(float lo, float hi) const {
+  std::string graph(values_.size() - size_, ' ');
+  graph.reserve(graph.size() + size_ * kBlocks[0].size());
+  const float range = hi - lo;
+  for (size_t i = 0; i < size_; ++i) {
+    int level = 0;
+    if (range > 0) {
+      level = std::clamp(static_cast<int>(std::lround(((*this)[i] - lo) / range * (kLevels - 1))),
+                         0, kLevels - 1);
+    }
+    graph.append(kBlocks[level]);
+  }
+  return graph;
+}
+
+size_t graphLength(const Json::Value& config) {
+  const auto& length = config["graph-length"];
+  return length.isUInt() && length.asUInt() > 0 ? length.asUInt() : kDefaultGraphLength;
+}
+
+}  // namespace waybar::util
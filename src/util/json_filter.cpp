@@ -0,0 +1,287 @@
+#include "util/json_filter.hpp"
+
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace waybar::util {
+
+class JsonFilter::Reader {
+ public:
+  Reader(const JsonFilter& filter, std::string_view data) : filter_(filter), data_(data) {}
+
+  Json::Value parseDocument() {
+    auto value = parseValue();
+    skipWhitespace();
+    if (pos_ != data_.size()) error("trailing data");
+    return value;
+  }
+
+ private:
+  [[noreturn]] void error(const char* what) const {
+    throw std::runtime_error("Invalid JSON at offset " + std::to_string(pos_) + ": " + what);
+  }
+
+  void skipWhitespace() {
+    while (pos_ < data_.size() && (data_[pos_] == ' ' || data_[pos_] == '\n' ||
+                                   data_[pos_] == '\r' || data_[pos_] == '\t')) {
+      ++pos_;
+    }
+  }
+
+  char peek() {
+    skipWhitespace();
+    if (pos_ >= data_.size()) error("unexpected end");
+    return data_[pos_];
+  }
+
+  void expect(char c) {
+    if (peek() != c) error("unexpected character");
+    ++pos_;
+  }
+
+  void expectLiteral(std::string_view literal) {
+    if (data_.substr(pos_, literal.size()) != literal) error("invalid literal");
+    pos_ += literal.size();
+  }
+
+  Json::Value parseValue() {
+    switch (peek()) {
+      case '{':
+        return parseObject();
+      case '[':
+        return parseArray();
+      case '"':
+        return Json::Value(parseString());
+      case 't':
+        expectLiteral("true");
+        return Json::Value(true);
+      case 'f':
+        expectLiteral("false");
+        return Json::Value(false);
+      case 'n':
+        expectLiteral("null");
+        return Json::Value();
+      default:
+        return parseNumber();
+    }
+  }
+
+  Json::Value parseObject() {
+    Json::Value object(Json::objectValue);
+    expect('{');
+    if (peek() == '}') {
+      ++pos_;
+      return object;
+    }
+    while (true) {
+      if (peek() != '"') error("expected member name");
+      // Member names in sway replies never contain escapes, so a view usually suffices
+      auto key = stringView();
+      expect(':');
+      if (filter_.wanted(key)) {
+        object[std::string(key)] = parseValue();
+      } else {
+        skipValue();
+      }
+      if (peek() == ',') {
+        ++pos_;
+        continue;
+      }
+      expect('}');
+      return object;
+    }
+  }
+
+  Json::Value parseArray() {
+    Json::Value array(Json::arrayValue);
+    expect('[');
+    if (peek() == ']') {
+      ++pos_;
+      return array;
+    }
+    while (true) {
+      array.append(parseValue());
+      if (peek() == ',') {
+        ++pos_;
+        continue;
+      }
+      expect(']');
+      return array;
+    }
+  }
+
+  Json::Value parseNumber() {
+    const auto start = pos_;
+    bool integer = true;
+    while (pos_ < data_.size()) {
+      const char c = data_[pos_];
+      if (c == '.' || c == 'e' || c == 'E') {
+        integer = false;
+      } else if (!(c == '-' || c == '+' || (c >= '0' && c <= '9'))) {
+        break;
+      }
+      ++pos_;
+    }
+    if (start == pos_) error("unexpected character");
+    const char* first = data_.data() + start;
+    const char* last = data_.data() + pos_;
+    if (integer) {
+      Json::Int64 value;
+      if (auto [ptr, ec] = std::from_chars(first, last, value); ec == std::errc() && ptr == last) {
+        return Json::Value(value);
+      }
+    }
+    // Fractions and integers that don't fit
+    return Json::Value(std::strtod(std::string(first, last).c_str(), nullptr));
+  }
+
+  // Returns the raw contents of a string and moves past it, without decoding escapes
+  std::string_view rawString() {
+    ++pos_;  // opening quote
+    const auto start = pos_;
+    while (pos_ < data_.size() && data_[pos_] != '"') {
+      pos_ += data_[pos_] == '\\' ? 2 : 1;
+    }
+    if (pos_ >= data_.size()) error("unterminated string");
+    return data_.substr(start, pos_++ - start);
+  }
+
+  std::string_view stringView() {
+    const auto start = pos_;
+    auto raw = rawString();
+    if (raw.find('\\') == std::string_view::npos) {
+      return raw;
+    }
+    pos_ = start;
+    scratch_ = parseString();
+    return scratch_;
+  }
+
+  std::string parseString() {
+    auto raw = rawString();
+    std::string result;
+    result.reserve(raw.size());
+    for (size_t i = 0; i < raw.size(); ++i) {
+      if (raw[i] != '\\') {
+        result.push_back(raw[i]);
+        continue;
+      }
+      switch (raw[++i]) {
+        case 'b':
+          result.push_back('\b');
+          break;
+        case 'f':
+          result.push_back('\f');
+          break;
+        case 'n':
+          result.push_back('\n');
+          break;
+        case 'r':
+          result.push_back('\r');
+          break;
+        case 't':
+          result.push_back('\t');
+          break;
+        case 'u': {
+          auto cp = hex4(raw, i + 1);
+          i += 4;
+          if (cp >= 0xD800 && cp < 0xDC00 && i + 6 < raw.size() && raw[i + 1] == '\\' &&
+              raw[i + 2] == 'u') {
+            auto low = hex4(raw, i + 3);
+            if (low >= 0xDC00 && low < 0xE000) {
+              cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+              i += 6;
+            }
+          }
+          appendUtf8(result, cp);
+          break;
+        }
+        default:  // '"', '\\' and '/'
+          result.push_back(raw[i]);
+      }
+    }
+    return result;
+  }
+
+  uint32_t hex4(std::string_view raw, size_t pos) const {
+    uint32_t value = 0;
+    if (pos + 4 > raw.size() ||
+        std::from_chars(raw.data() + pos, raw.data() + pos + 4, value, 16).ptr !=
+            raw.data() + pos + 4) {
+      error("invalid unicode escape");
+    }
+    return value;
+  }
+
+  static void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+      out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+      out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+      out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+      out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+      out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  // Skips a value of any type without allocating
+  void skipValue() {
+    size_t depth = 0;
+    do {
+      switch (peek()) {
+        case '{':
+        case '[':
+          ++depth;
+          ++pos_;
+          break;
+        case '}':
+        case ']':
+          if (depth == 0) error("unexpected character");
+          --depth;
+          ++pos_;
+          break;
+        case '"':
+          rawString();
+          break;
+        case ',':
+        case ':':
+          if (depth == 0) error("unexpected character");
+          ++pos_;
+          break;
+        default:
+          // numbers and literals
+          while (pos_ < data_.size() && data_[pos_] != ',' && data_[pos_] != '}' &&
+                 data_[pos_] != ']' && data_[pos_] != ' ' && data_[pos_] != '\n') {
+            ++pos_;
+          }
+      }
+    } while (depth > 0);
+  }
+
+  const JsonFilter& filter_;
+  std::string_view data_;
+  size_t pos_ = 0;
+  std::string scratch_;
+};
+
+JsonFilter::JsonFilter(std::initializer_list<std::string_view> keys)
+    : keys_(keys.begin(), keys.end()) {}
+
+bool JsonFilter::wanted(std::string_view key) const {
+  return std::find(keys_.begin(), keys_.end(), key) != keys_.end();
+}
+
+Json::Value JsonFilter::parse(std::string_view data) const {
+  return Reader(*this, data).parseDocument();
+}
+
+}  // namespace waybar::util
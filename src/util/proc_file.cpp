@@ -0,0 +1,70 @@
+#include "util/proc_file.hpp"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <stdexcept>
+#include <utility>
+
+namespace waybar::util {
+
+ProcFile::ProcFile(std::string path) : path_(std::move(path)), buffer_(4096) {}
+
+ProcFile::ProcFile(ProcFile&& other) noexcept
+    : path_(std::move(other.path_)), fd_(other.fd_), buffer_(std::move(other.buffer_)) {
+  other.fd_ = -1;
+}
+
+ProcFile& ProcFile::operator=(ProcFile&& other) noexcept {
+  if (this != &other) {
+    close();
+    path_ = std::move(other.path_);
+    fd_ = other.fd_;
+    buffer_ = std::move(other.buffer_);
+    other.fd_ = -1;
+  }
+  return *this;
+}
+
+ProcFile::~ProcFile() { close(); }
+
+void ProcFile::close() {
+  if (fd_ != -1) {
+    ::close(fd_);
+    fd_ = -1;
+  }
+}
+
+std::string_view ProcFile::read() {
+  if (fd_ == -1) {
+    fd_ = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd_ == -1) {
+      throw std::runtime_error("Can't open " + path_);
+    }
+  }
+
+  size_t size = 0;
+  while (true) {
+    if (size == buffer_.size()) {
+      buffer_.resize(buffer_.size() * 2);
+    }
+    // Reading from offset 0 makes the kernel generate fresh contents
+    auto res = ::pread(fd_, buffer_.data() + size, buffer_.size() - size, size);
+    if (res == -1) {
+      if (errno == EINTR) {
+        continue;
+      }
+      // e.g. the device behind a sysfs file went away, reopen on the next read
+      close();
+      throw std::runtime_error("Can't read " + path_);
+    }
+    if (res == 0) {
+      break;
+    }
+    size += res;
+  }
+  return {buffer_.data(), size};
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,43 @@
+#include "util/proc_stat.hpp"
+
+namespace waybar::util {
+
+void parseProcStat(std::string_view data, CpuTimes& times) {
+  // The cpu lines come first: "cpu  user nice system idle iowait irq ...", then "cpu0 ...", etc.
+  const char* p = data.data();
+  const char* const end = p + data.size();
+  size_t cpu = 0;
+  while (end - p > 3 && p[0] == 'c' && p[1] == 'p' && p[2] == 'u') {
+    while (p < end && *p != ' ') ++p;
+
+    uint64_t idle_time = 0;
+    uint64_t total_time = 0;
+    size_t field = 0;
+    while (p < end && *p != '\n') {
+      if (*p < '0' || *p > '9') {
+        ++p;
+        continue;
+      }
+      uint64_t time = 0;
+      for (; p < end && *p >= '0' && *p <= '9'; ++p) {
+        time = time * 10 + (*p - '0');
+      }
+      if (field++ == 3) idle_time = time;
+      total_time += time;
+    }
+    ++p;
+
+    if (cpu == times.idle.size()) {
+      times.idle.push_back(idle_time);
+      times.total.push_back(total_time);
+    } else {
+      times.idle[cpu] = idle_time;
+      times.total[cpu] = total_time;
+    }
+    ++cpu;
+  }
+  times.idle.resize(cpu);
+  times.total.resize(cpu);
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,437 @@
+#include "util/reactor.hpp"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/syscall.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace waybar::util {
+
+namespace {
+
+// Without pidfd, exits of children that closed their output are polled at this interval
+constexpr int kExitPollMs = 50;
+// Reads per child and wakeup, so that a chatty child doesn't starve the others
+constexpr int kMaxReads = 4;
+
+int openPidfd(pid_t pid) {
+#ifdef SYS_pidfd_open
+  return syscall(SYS_pidfd_open, pid, 0);
+#else
+  return -1;
+#endif
+}
+
+}  // namespace
+
+Process::Process(Process&& other) noexcept : reactor_(other.reactor_), id_(other.id_) {
+  other.reactor_ = nullptr;
+  other.id_ = 0;
+}
+
+Process& Process::operator=(Process&& other) noexcept {
+  if (this != &other) {
+    cancel();
+    reactor_ = other.reactor_;
+    id_ = other.id_;
+    other.reactor_ = nullptr;
+    other.id_ = 0;
+  }
+  return *this;
+}
+
+void Process::cancel() {
+  if (reactor_ != nullptr) reactor_->cancel(id_);
+  reactor_ = nullptr;
+  id_ = 0;
+}
+
+bool Process::running() const { return reactor_ != nullptr && reactor_->running(id_); }
+
+void Process::detach() {
+  if (reactor_ != nullptr) reactor_->detach(id_);
+  reactor_ = nullptr;
+  id_ = 0;
+}
+
+Reactor& Reactor::inst() {
+  static Reactor instance;
+  return instance;
+}
+
+Reactor::Reactor() {
+  wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+  if (wake_fd_ == -1) {
+    throw std::runtime_error(std::string("Can't create the reactor eventfd: ") + strerror(errno));
+  }
+  thread_ = std::thread([this] { run(); });
+}
+
+Reactor::~Reactor() {
+  const auto stats = this->stats();
+  spdlog::debug("{} processes spawned, {} failed, {}us average and {}us max spawn time",
+                stats.spawned, stats.failed,
+                stats.spawned == 0 ? 0 : stats.spawn_time.count() / 1000 / stats.spawned,
+                stats.max_spawn_time.count() / 1000);
+  {
+    std::lock_guard lock(mutex_);
+    do_run_ = false;
+  }
+  wake();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+  // posix_spawn can't ask for a signal on the death of the bar, terminate the groups here. Also
+  // those of exited children, whose group may still be writing to the output.
+  for (auto& [id, child] : children_) {
+    if (child->pid > 0 && (!child->exited || child->out != -1)) {
+      killpg(child->pid, SIGTERM);
+    }
+    if (child->out != -1) ::close(child->out);
+    if (child->pidfd != -1) ::close(child->pidfd);
+  }
+  ::close(wake_fd_);
+}
+
+Process Reactor::exec(std::vector<Step> steps, const command::limits& limits, Done done) {
+  auto child = std::make_shared<Child>();
+  child->steps = std::move(steps);
+  child->limits = limits;
+  child->done = std::move(done);
+  return add(std::move(child));
+}
+
+Process Reactor::stream(const std::string& cmd, Line line, Done done) {
+  auto child = std::make_shared<Child>();
+  child->steps.push_back({cmd, nullptr});
+  child->streaming = true;
+  child->line = std::move(line);
+  child->done = std::move(done);
+  return add(std::move(child));
+}
+
+Process Reactor::spawn(const std::string& cmd, Done done) {
+  auto child = std::make_shared<Child>();
+  child->steps.push_back({cmd, nullptr});
+  child->inherit_output = true;
+  child->done = std::move(done);
+  return add(std::move(child));
+}
+
+auto Reactor::stats() const -> Stats {
+  return {spawned_, failed_, std::chrono::nanoseconds(spawn_ns_),
+          std::chrono::nanoseconds(max_spawn_ns_)};
+}
+
+pid_t Reactor::start(Child& child) {
+  if (child.cmd.empty()) {
+    return -1;
+  }
+  child.output.clear();
+  pid_t pid = -1;
+  const auto begin = std::chrono::steady_clock::now();
+  if (child.inherit_output) {
+    pid = command::spawn(child.cmd, -1);
+  } else if (child.streaming) {
+    // Endless scripts are forked, to have them killed along with the bar
+    child.out = command::openFd(child.cmd, pid);
+  } else {
+    int fd[2];
+    if (pipe2(fd, O_CLOEXEC) != 0) {
+      spdlog::error("Unable to pipe fd");
+      return -1;
+    }
+    pid = command::spawn(child.cmd, fd[1]);
+    ::close(fd[1]);
+    child.out = fd[0];
+    if (pid == -1) {
+      ::close(child.out);
+      child.out = -1;
+    }
+  }
+  if (pid == -1 || (child.out == -1 && !child.inherit_output)) {
+    ++failed_;
+    return -1;
+  }
+  const int64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                              std::chrono::steady_clock::now() - begin)
+                              .count();
+  ++spawned_;
+  spawn_ns_ += elapsed;
+  for (auto max = max_spawn_ns_.load(); elapsed > max;) {
+    if (max_spawn_ns_.compare_exchange_weak(max, elapsed)) break;
+  }
+  if (child.out != -1) {
+    fcntl(child.out, F_SETFL, fcntl(child.out, F_GETFL) | O_NONBLOCK);
+  }
+  child.pidfd = openPidfd(pid);
+  child.deadline = child.limits.timeout.count() > 0
+                       ? std::chrono::steady_clock::now() + child.limits.timeout
+                       : std::chrono::steady_clock::time_point::max();
+  return pid;
+}
+
+pid_t Reactor::startNext(Child& child, command::res& last) {
+  while (child.step < child.steps.size()) {
+    auto& step = child.steps[child.step++];
+    if (!step.cmd.empty()) {
+      child.cmd = step.cmd;
+      const auto pid = start(child);
+      if (pid == -1) last = {-1, ""};
+      return pid;
+    }
+    if (step.proceed && !step.proceed(last)) return -1;
+  }
+  return -1;
+}
+
+Process Reactor::add(std::shared_ptr<Child> child) {
+  command::res result{0, ""};
+  child->pid = startNext(*child, result);
+  if (child->pid == -1) {
+    child->done(std::move(result));
+    return {};
+  }
+  uint64_t id;
+  {
+    std::lock_guard lock(mutex_);
+    id = next_id_++;
+    children_.emplace(id, std::move(child));
+  }
+  wake();
+  return Process(this, id);
+}
+
+void Reactor::cancel(uint64_t id) {
+  std::unique_lock lock(mutex_);
+  auto it = children_.find(id);
+  if (it == children_.end()) return;
+  it->second->cancelled = true;
+  kill(*it->second);
+  wake();
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    idle_cv_.wait(lock, [this, id] { return running_ != id; });
+  }
+}
+
+void Reactor::detach(uint64_t id) {
+  std::unique_lock lock(mutex_);
+  auto it = children_.find(id);
+  if (it == children_.end()) return;
+  it->second->detached = true;
+  // The callbacks may refer to the owner of the handle, which is free to go from here on
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    idle_cv_.wait(lock, [this, id] { return running_ != id; });
+  }
+}
+
+bool Reactor::running(uint64_t id) {
+  std::lock_guard lock(mutex_);
+  auto it = children_.find(id);
+  return it != children_.end() && !it->second->finished;
+}
+
+void Reactor::kill(Child& child) {
+  if (!child.exited && !child.killed && child.pid > 0) {
+    killpg(child.pid, SIGTERM);
+    child.killed = true;
+    child.kill_deadline = std::chrono::steady_clock::now() + command::kill_grace;
+  }
+}
+
+void Reactor::wake() {
+  const uint64_t one = 1;
+  while (write(wake_fd_, &one, sizeof(one)) == -1 && errno == EINTR) {
+  }
+}
+
+void Reactor::reap(Child& child) {
+  int stat;
+  const auto ret = waitpid(child.pid, &stat, WNOHANG);
+  if (ret == child.pid || (ret == -1 && errno == ECHILD)) {
+    child.exited = true;
+    child.status = ret == child.pid ? stat : -1;
+    if (child.pidfd != -1) {
+      ::close(child.pidfd);
+      child.pidfd = -1;
+    }
+  }
+}
+
+void Reactor::readOutput(uint64_t id, const std::shared_ptr<Child>& child) {
+  auto& c = *child;
+  for (int i = 0; i < kMaxReads; ++i) {
+    const auto n = ::read(c.out, buffer_.data(), buffer_.size());
+    if (n == -1 && errno == EINTR) continue;
+    if (n == -1 && errno == EAGAIN) return;
+    if (n > 0 && c.streaming) {
+      std::string_view data(buffer_.data(), n);
+      for (auto end = data.find('\n'); end != std::string_view::npos; end = data.find('\n')) {
+        c.output.append(data.substr(0, end));
+        callbacks_.push_back({id, child, false, std::move(c.output), {}});
+        c.output.clear();
+        data.remove_prefix(end + 1);
+      }
+      c.output.append(data);
+      if (c.output.size() < c.limits.max_output) continue;
+      // Pass an overlong line on in pieces
+      callbacks_.push_back({id, child, false, std::move(c.output), {}});
+      c.output.clear();
+      continue;
+    }
+    if (n > 0) {
+      const auto left = c.limits.max_output - c.output.size();
+      c.output.append(buffer_.data(), std::min<size_t>(n, left));
+      if (static_cast<size_t>(n) < left) continue;
+      spdlog::warn("Cmd {} wrote more than {} bytes", c.cmd, c.limits.max_output);
+      kill(c);
+    }
+    // End of output, an error, or the output cap was reached
+    if (c.streaming && !c.output.empty()) {
+      callbacks_.push_back({id, child, false, std::move(c.output), {}});
+      c.output.clear();
+    }
+    ::close(c.out);
+    c.out = -1;
+    return;
+  }
+}
+
+void Reactor::run() {
+  std::vector<pollfd> fds;
+  std::unique_lock lock(mutex_);
+  while (do_run_) {
+    fds.assign(1, {wake_fd_, POLLIN, 0});
+    int timeout = -1;
+    const auto now = std::chrono::steady_clock::now();
+    for (auto& [id, child] : children_) {
+      child->out_index = -1;
+      child->pidfd_index = -1;
+      if (child->out != -1) {
+        child->out_index = fds.size();
+        fds.push_back({child->out, POLLIN, 0});
+      }
+      if (child->pidfd != -1) {
+        child->pidfd_index = fds.size();
+        fds.push_back({child->pidfd, POLLIN, 0});
+      } else if (!child->exited && child->out == -1) {
+        timeout = timeout == -1 ? kExitPollMs : std::min(timeout, kExitPollMs);
+      }
+      auto deadline = std::chrono::steady_clock::time_point::max();
+      if (!child->exited && !child->killed) {
+        deadline = child->deadline;
+      } else if (child->killed && !child->force_killed && (!child->exited || child->out != -1)) {
+        deadline = child->kill_deadline;
+      }
+      if (deadline != std::chrono::steady_clock::time_point::max()) {
+        const auto left = std::max<int64_t>(
+            0, std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count());
+        timeout = timeout == -1 ? left : std::min<int64_t>(timeout, left);
+      }
+    }
+
+    lock.unlock();
+    while (poll(fds.data(), fds.size(), timeout) == -1 && errno == EINTR) {
+    }
+    if (fds[0].revents != 0) {
+      uint64_t count;
+      ::read(wake_fd_, &count, sizeof(count));
+    }
+    lock.lock();
+
+    const auto polled = std::chrono::steady_clock::now();
+    for (auto& [id, child] : children_) {
+      auto& c = *child;
+      if (c.cancelled && c.out != -1) {
+        ::close(c.out);
+        c.out = -1;
+      } else if (c.out_index != -1 && fds[c.out_index].revents != 0) {
+        readOutput(id, child);
+      }
+      if ((c.pidfd_index != -1 && fds[c.pidfd_index].revents != 0) ||
+          (c.pidfd == -1 && !c.exited && c.out == -1)) {
+        reap(c);
+      }
+      if (!c.exited && !c.killed && polled >= c.deadline) {
+        spdlog::warn("Cmd {} timed out after {}ms", c.cmd, c.limits.timeout.count());
+        kill(c);
+      } else if (c.killed && !c.force_killed && (!c.exited || c.out != -1) &&
+                 polled >= c.kill_deadline) {
+        // Also the rest of its group, that may hold on to the output after it exited
+        spdlog::warn("Cmd {} ignored SIGTERM, killing it", c.cmd);
+        killpg(c.pid, SIGKILL);
+        c.force_killed = true;
+      }
+      if (!c.exited || c.out != -1 || c.finished) continue;
+
+      command::res result{c.status == -1 ? -1 : command::exitCode(c.status), std::move(c.output)};
+      // Remove last newline
+      if (!c.streaming && !result.out.empty() && result.out.back() == '\n') {
+        result.out.pop_back();
+      }
+      if (!c.cancelled && !c.detached) {
+        const auto& step = c.steps[c.step - 1];
+        if (step.proceed ? step.proceed(result) : result.exit_code == 0) {
+          // Started below, once unlocked
+          c.pid = -1;
+          starting_.push_back({id, child, std::move(result), -1});
+          continue;
+        }
+      }
+      c.finished = true;
+      callbacks_.push_back({id, child, true, {}, std::move(result)});
+    }
+
+    // Spawning takes a while, the next steps start unlocked and are published after
+    if (!starting_.empty()) {
+      lock.unlock();
+      for (auto& next : starting_) {
+        next.pid = startNext(*next.child, next.last);
+      }
+      lock.lock();
+      for (auto& next : starting_) {
+        auto& c = *next.child;
+        if (next.pid == -1) {
+          c.finished = true;
+          callbacks_.push_back({next.id, next.child, true, {}, std::move(next.last)});
+          continue;
+        }
+        c.pid = next.pid;
+        c.exited = false;
+        c.killed = false;
+        c.force_killed = false;
+        // Cancelled meanwhile
+        if (c.cancelled) kill(c);
+      }
+      starting_.clear();
+    }
+
+    // Callbacks run unlocked, so that they may start other processes
+    for (auto& callback : callbacks_) {
+      auto& c = *callback.child;
+      if (!c.cancelled && !c.detached) {
+        running_ = callback.id;
+        lock.unlock();
+        if (callback.done) {
+          c.done(std::move(callback.result));
+        } else {
+          c.line(callback.line);
+        }
+        lock.lock();
+        running_ = 0;
+        idle_cv_.notify_all();
+      }
+      if (callback.done) {
+        children_.erase(callback.id);
+      }
+    }
+    callbacks_.clear();
+  }
+}
+
+}  // namespace waybar::util
@@ -3,58 +3,172 @@
 #include <fmt/core.h>
 #include <spdlog/spdlog.h>
 
+#include <mutex>
+#include <optional>
 #include <regex>
+#include <unordered_map>
+#include <vector>
+
+#include "util/lru_cache.hpp"
 
 namespace waybar::util {
 std::string rewriteString(const std::string& value, const Json::Value& rules) {
   if (!rules.isObject()) {
     return value;
   }
+  return RewriteRules(rules).apply(value);
+}
+
+std::string rewriteStringOnce(const std::string& value, const Json::Value& rules,
+                              bool& matched_any) {
+  matched_any = false;
+  if (!rules.isObject()) {
+    return value;
+  }
+  return RewriteRules(rules).applyOnce(value, matched_any);
+}
+
+namespace {
+
+struct Result {
+  std::string value;
+  bool matched_any;
+};
+
+class ResultCache {
+ public:
+  static ResultCache& inst() {
+    static ResultCache cache;
+    return cache;
+  }
+
+  ~ResultCache() {
+    spdlog::debug("Rewrite cache: {} hits, {} misses, {} evictions", cache_.hits(),
+                  cache_.misses(), cache_.evictions());
+  }
+
+  std::optional<Result> find(const std::string& key) {
+    std::lock_guard lock(mutex_);
+    if (const auto* result = cache_.find(key)) {
+      return *result;
+    }
+    return std::nullopt;
+  }
+
+  void put(const std::string& key, const Result& result) {
+    std::lock_guard lock(mutex_);
+    cache_.put(key, result);
+  }
+
+  RewriteRules::CacheStats stats() {
+    std::lock_guard lock(mutex_);
+    return {cache_.size(), cache_.capacity(), cache_.hits(), cache_.misses(), cache_.evictions()};
+  }
+
+ private:
+  ResultCache() : cache_(RewriteRules::kCacheSize) {}
+
+  std::mutex mutex_;
+  LruCache<std::string, Result> cache_;
+};
+
+}  // namespace
+
+struct RewriteRules::RuleSet {
+  struct Rule {
+    std::regex regex;
+    std::string replacement;
+  };
+
+  // distinguishes the results of rule sets in the shared cache
+  uint64_t id;
+  std::vector<Rule> rules;
+};
+
+RewriteRules::RewriteRules(const Json::Value& rules) {
+  if (!rules.isObject()) {
+    return;
+  }
+  // Rule sets are interned by their keys and values
+  std::string source;
+  for (auto it = rules.begin(); it != rules.end(); ++it) {
+    if (it.key().isString() && it->isString()) {
+      source.append(it.key().asString()).push_back('\0');
+      source.append(it->asString()).push_back('\0');
+    }
+  }
 
-  std::string res = value;
+  static std::mutex mutex;
+  static std::unordered_map<std::string, std::weak_ptr<const RuleSet>> sets;
+  static uint64_t next_id = 1;
+  std::lock_guard lock(mutex);
+  if (auto set = sets[source].lock()) {
+    rules_ = std::move(set);
+    return;
+  }
+  std::erase_if(sets, [](const auto& entry) { return entry.second.expired(); });
 
+  auto set = std::make_shared<RuleSet>();
+  set->id = next_id++;
   for (auto it = rules.begin(); it != rules.end(); ++it) {
     if (it.key().isString() && it->isString()) {
       try {
         // malformated regexes will cause an exception.
         // in this case, log error and try the next rule.
-        const std::regex rule{it.key().asString(), std::regex_constants::icase};
-        if (std::regex_match(value, rule)) {
-          res = std::regex_replace(res, rule, it->asString());
-        }
+        set->rules.push_back({std::regex{it.key().asString(), std::regex_constants::icase |
+                                                                  std::regex_constants::optimize},
+                              it->asString()});
       } catch (const std::regex_error& e) {
         spdlog::error("Invalid rule {}: {}", it.key().asString(), e.what());
       }
     }
   }
-
-  return res;
+  sets[source] = set;
+  rules_ = std::move(set);
 }
 
-std::string rewriteStringOnce(const std::string& value, const Json::Value& rules,
-                              bool& matched_any) {
-  if (!rules.isObject()) {
+bool RewriteRules::empty() const { return !rules_ || rules_->rules.empty(); }
+
+std::string RewriteRules::apply(const std::string& value) const {
+  if (empty()) {
     return value;
   }
+  const auto key = fmt::format("{}a{}", rules_->id, value);
+  if (auto cached = ResultCache::inst().find(key)) {
+    return std::move(cached->value);
+  }
+  Result result{value, false};
+  for (const auto& rule : rules_->rules) {
+    if (std::regex_match(value, rule.regex)) {
+      result.value = std::regex_replace(result.value, rule.regex, rule.replacement);
+      result.matched_any = true;
+    }
+  }
+  ResultCache::inst().put(key, result);
+  return std::move(result.value);
+}
 
+std::string RewriteRules::applyOnce(const std::string& value, bool& matched_any) const {
   matched_any = false;
-
-  std::string res = value;
-
-  for (auto it = rules.begin(); it != rules.end(); ++it) {
-    if (it.key().isString() && it->isString()) {
-      try {
-        const std::regex rule{it.key().asString(), std::regex_constants::icase};
-        if (std::regex_match(value, rule)) {
-          matched_any = true;
-          return std::regex_replace(res, rule, it->asString());
-        }
-      } catch (const std::regex_error& e) {
-        spdlog::error("Invalid rule {}: {}", it.key().asString(), e.what());
-      }
+  if (empty()) {
+    return value;
+  }
+  const auto key = fmt::format("{}o{}", rules_->id, value);
+  if (auto cached = ResultCache::inst().find(key)) {
+    matched_any = cached->matched_any;
+    return std::move(cached->value);
+  }
+  Result result{value, false};
+  for (const auto& rule : rules_->rules) {
+    if (std::regex_match(value, rule.regex)) {
+      result = {std::regex_replace(value, rule.regex, rule.replacement), true};
+      break;
     }
   }
-
-  return value;
+  ResultCache::inst().put(key, result);
+  matched_any = result.matched_any;
+  return std::move(result.value);
 }
+
+auto RewriteRules::cacheStats() -> CacheStats { return ResultCache::inst().stats(); }
 }  // namespace waybar::util
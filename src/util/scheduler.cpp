@@ -0,0 +1,178 @@
+#include "util/scheduler.hpp"
+
+#include <algorithm>
+
+#include "util/prepare_for_sleep.h"
+
+namespace waybar::util {
+
+Timer::Timer(Timer&& other) noexcept : scheduler_(other.scheduler_), id_(other.id_) {
+  other.scheduler_ = nullptr;
+  other.id_ = 0;
+}
+
+Timer& Timer::operator=(Timer&& other) noexcept {
+  if (this != &other) {
+    cancel();
+    scheduler_ = other.scheduler_;
+    id_ = other.id_;
+    other.scheduler_ = nullptr;
+    other.id_ = 0;
+  }
+  return *this;
+}
+
+void Timer::wake_up() {
+  if (scheduler_ != nullptr) scheduler_->wake_up(id_);
+}
+
+void Timer::cancel() {
+  if (scheduler_ != nullptr) scheduler_->cancel(id_);
+  scheduler_ = nullptr;
+  id_ = 0;
+}
+
+Scheduler& Scheduler::inst() {
+  static Scheduler instance;
+  return instance;
+}
+
+Scheduler::Scheduler() {
+  // Deadlines have most likely passed while suspended, run everything on resume
+  connection_ = prepare_for_sleep().connect([this](bool sleep) {
+    if (not sleep) wakeAll();
+  });
+  thread_ = std::thread([this] { run(); });
+}
+
+Scheduler::~Scheduler() {
+  connection_.disconnect();
+  {
+    std::lock_guard lock(mutex_);
+    do_run_ = false;
+  }
+  wake_cv_.notify_all();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+}
+
+bool Scheduler::laterEntry(const Entry& a, const Entry& b) { return a.latest > b.latest; }
+
+Scheduler::clock::duration Scheduler::defaultSlack(clock::duration interval) {
+  return std::min<clock::duration>(interval / 20, std::chrono::milliseconds(250));
+}
+
+Timer Scheduler::every(clock::duration interval, Callback callback, bool aligned) {
+  auto task = std::make_shared<Task>(Task{.interval = interval,
+                                          .slack = defaultSlack(interval),
+                                          .aligned = aligned,
+                                          .callback = std::move(callback)});
+  uint64_t id;
+  {
+    std::lock_guard lock(mutex_);
+    id = next_id_++;
+    schedule(id, *task, clock::now());
+    tasks_.emplace(id, std::move(task));
+  }
+  wake_cv_.notify_all();
+  return Timer(this, id);
+}
+
+void Scheduler::schedule(uint64_t id, Task& task, clock::time_point deadline) {
+  task.deadline = deadline;
+  ++task.generation;
+  heap_.push_back({deadline, deadline + task.slack, id, task.generation});
+  std::push_heap(heap_.begin(), heap_.end(), laterEntry);
+}
+
+void Scheduler::cancel(uint64_t id) {
+  std::unique_lock lock(mutex_);
+  tasks_.erase(id);
+  // Stale heap entries are dropped lazily by the scheduler thread
+  if (std::this_thread::get_id() != thread_.get_id()) {
+    idle_cv_.wait(lock, [this, id] { return running_ != id; });
+  }
+}
+
+void Scheduler::wake_up(uint64_t id) {
+  {
+    std::lock_guard lock(mutex_);
+    auto it = tasks_.find(id);
+    if (it == tasks_.end()) return;
+    schedule(id, *it->second, clock::now());
+  }
+  wake_cv_.notify_all();
+}
+
+void Scheduler::wakeAll() {
+  {
+    std::lock_guard lock(mutex_);
+    auto now = clock::now();
+    for (auto& [id, task] : tasks_) {
+      schedule(id, *task, now);
+    }
+  }
+  wake_cv_.notify_all();
+}
+
+void Scheduler::run() {
+  std::vector<std::pair<uint64_t, std::shared_ptr<Task>>> due;
+  std::unique_lock lock(mutex_);
+  while (do_run_) {
+    // Drop entries of cancelled or rescheduled tasks
+    while (!heap_.empty()) {
+      auto it = tasks_.find(heap_.front().id);
+      if (it != tasks_.end() && it->second->generation == heap_.front().generation) break;
+      std::pop_heap(heap_.begin(), heap_.end(), laterEntry);
+      heap_.pop_back();
+    }
+    if (heap_.empty()) {
+      wake_cv_.wait(lock);
+      continue;
+    }
+
+    auto now = clock::now();
+    if (heap_.front().latest > now) {
+      // Any reschedule or new task notifies us, so the heap top is reevaluated
+      wake_cv_.wait_until(lock, heap_.front().latest);
+      continue;
+    }
+
+    // Run every task whose deadline has been reached, not only the one that woke us up
+    while (!heap_.empty() && heap_.front().deadline <= now) {
+      auto entry = heap_.front();
+      std::pop_heap(heap_.begin(), heap_.end(), laterEntry);
+      heap_.pop_back();
+      auto it = tasks_.find(entry.id);
+      if (it == tasks_.end() || it->second->generation != entry.generation) continue;
+
+      auto& task = *it->second;
+      if (task.interval > clock::duration::zero()) {
+        clock::time_point next;
+        if (task.aligned) {
+          next = now + task.interval - now.time_since_epoch() % task.interval;
+        } else {
+          next = task.deadline + task.interval;
+          // Don't try to catch up on missed runs
+          if (next <= now) next = now + task.interval;
+        }
+        schedule(entry.id, task, next);
+      }
+      due.emplace_back(entry.id, it->second);
+    }
+
+    for (auto& [id, task] : due) {
+      if (tasks_.find(id) == tasks_.end()) continue;
+      running_ = id;
+      lock.unlock();
+      task->callback();
+      lock.lock();
+      running_ = 0;
+      idle_cv_.notify_all();
+    }
+    due.clear();
+  }
+}
+
+}  // namespace waybar::util
@@ -0,0 +1,72 @@
+#include "util/update_batcher.hpp"
+
+namespace waybar::util {
+
+UpdateBatcher::UpdateBatcher(Gtk::Widget& widget, std::chrono::milliseconds max_latency)
+    : widget_(widget), max_latency_(max_latency) {}
+
+UpdateBatcher::~UpdateBatcher() {
+  if (tick_id_ != 0) {
+    widget_.remove_tick_callback(tick_id_);
+  }
+  timeout_.disconnect();
+}
+
+size_t UpdateBatcher::add(std::function<void()> update) {
+  updates_.push_back(std::move(update));
+  pending_.push_back(false);
+  return updates_.size() - 1;
+}
+
+void UpdateBatcher::schedule(size_t id) {
+  if (max_latency_.count() == 0) {
+    updates_[id]();
+    return;
+  }
+  if (pending_[id]) {
+    return;
+  }
+  pending_[id] = true;
+  queue_.push_back(id);
+  if (queue_.size() == 1) {
+    arm();
+  }
+}
+
+void UpdateBatcher::arm() {
+  // Without a frame clock, before the bar is mapped, only the timeout applies
+  if (widget_.get_mapped()) {
+    tick_id_ = widget_.add_tick_callback([this](const Glib::RefPtr<Gdk::FrameClock>&) {
+      // Returning false removes the callback
+      tick_id_ = 0;
+      flush();
+      return false;
+    });
+  }
+  timeout_ = Glib::signal_timeout().connect(
+      [this] {
+        flush();
+        return false;
+      },
+      max_latency_.count());
+}
+
+void UpdateBatcher::flush() {
+  if (tick_id_ != 0) {
+    widget_.remove_tick_callback(tick_id_);
+    tick_id_ = 0;
+  }
+  timeout_.disconnect();
+
+  // Updates scheduled while flushing go to the next frame
+  std::swap(queue_, flushing_);
+  for (auto id : flushing_) {
+    pending_[id] = false;
+  }
+  for (auto id : flushing_) {
+    updates_[id]();
+  }
+  flushing_.clear();
+}
+
+}  // namespace waybar::util
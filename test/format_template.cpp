@@ -0,0 +1,65 @@
+#include "util/format_template.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using waybar::util::FormatTemplate;
+
+namespace {
+
+// Renders fields from a fixed set of values, the name itself for unknown ones
+std::string render(const FormatTemplate& tmpl) {
+  return tmpl.render([](std::string_view name, auto& out) {
+    if (name == "usage") {
+      out.write(42);
+    } else if (name == "load") {
+      out.write(1.5);
+    } else if (name != "missing") {
+      out.write(name);
+    }
+  });
+}
+
+}  // namespace
+
+TEST_CASE("Parse and render format templates", "[util][format]") {
+  SECTION("literal text") {
+    FormatTemplate tmpl("no fields");
+    REQUIRE(render(tmpl) == "no fields");
+    REQUIRE_FALSE(tmpl.empty());
+    REQUIRE(FormatTemplate("").empty());
+  }
+  SECTION("named fields") {
+    FormatTemplate tmpl("{usage}% {load}");
+    REQUIRE(render(tmpl) == "42% 1.5");
+    REQUIRE(tmpl.references("usage"));
+    REQUIRE(tmpl.references("load"));
+    REQUIRE_FALSE(tmpl.references("icon"));
+  }
+  SECTION("positional fields are named by their index") {
+    REQUIRE(render(FormatTemplate("{} {} {0}")) == "0 1 0");
+    REQUIRE(FormatTemplate("{}").references("0"));
+  }
+  SECTION("escaped braces") {
+    REQUIRE(render(FormatTemplate("{{usage}} {{{usage}}}")) == "{usage} {42}");
+    REQUIRE(render(FormatTemplate("}}")) == "}");
+  }
+  SECTION("format specs") {
+    REQUIRE(render(FormatTemplate("{usage:>4}|{load:.2f}|{usage:02}")) == "  42|1.50|42");
+  }
+  SECTION("renderTo replaces the output") {
+    std::string out = "previous";
+    FormatTemplate("{usage}").renderTo(out, [](std::string_view, auto& writer) { writer.write(7); });
+    REQUIRE(out == "7");
+  }
+}
+
+TEST_CASE("Reject malformed format templates", "[util][format]") {
+  REQUIRE_THROWS_AS(FormatTemplate("{usage"), fmt::format_error);
+  REQUIRE_THROWS_AS(FormatTemplate("usage}"), fmt::format_error);
+  REQUIRE_THROWS_AS(FormatTemplate("{usage:{width}}"), fmt::format_error);
+  REQUIRE_THROWS_AS(render(FormatTemplate("{missing}")), fmt::format_error);
+}
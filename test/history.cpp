@@ -0,0 +1,75 @@
+#include "util/history.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using waybar::util::History;
+
+TEST_CASE("Empty history", "[util][history]") {
+  History history(3);
+  REQUIRE(history.empty());
+  REQUIRE(history.capacity() == 3);
+  REQUIRE(history.min() == 0);
+  REQUIRE(history.max() == 0);
+  REQUIRE(history.avg() == 0);
+  REQUIRE(history.sparkline(0, 100) == "   ");
+  REQUIRE(History(0).capacity() == 1);
+}
+
+TEST_CASE("Track the extrema of the window", "[util][history]") {
+  History history(3);
+  history.push(5);
+  history.push(1);
+  history.push(4);
+  REQUIRE(history.size() == 3);
+  REQUIRE(history.min() == 1);
+  REQUIRE(history.max() == 5);
+
+  SECTION("the maximum leaves the window") {
+    history.push(3);
+    REQUIRE(history[0] == 1);
+    REQUIRE(history[2] == 3);
+    REQUIRE(history.min() == 1);
+    REQUIRE(history.max() == 4);
+  }
+  SECTION("the minimum leaves the window") {
+    history.push(3);
+    history.push(2);
+    REQUIRE(history.min() == 2);
+    REQUIRE(history.max() == 4);
+    REQUIRE(history.avg() == 3);
+  }
+  SECTION("equal values stay in the window") {
+    history.push(4);
+    history.push(4);
+    history.push(4);
+    REQUIRE(history.min() == 4);
+    REQUIRE(history.max() == 4);
+  }
+}
+
+TEST_CASE("Averages of the history", "[util][history]") {
+  History history(3);
+  history.push(2);
+  REQUIRE(history.avg() == 2);
+  REQUIRE(history.ewma() == 2);
+  history.push(4);
+  REQUIRE(history.avg() == 3);
+  // alpha = 2 / (3 + 1)
+  REQUIRE(history.ewma() == 3);
+  history.push(6);
+  history.push(8);
+  REQUIRE(history.avg() == 6);
+}
+
+TEST_CASE("Draw the history", "[util][history]") {
+  History history(4);
+  history.push(0);
+  history.push(50);
+  history.push(100);
+  REQUIRE(history.sparkline(0, 100) == " ▁▅█");
+  REQUIRE(history.sparkline(0, 0) == " ▁▁▁");
+}
@@ -0,0 +1,99 @@
+#include "util/json_filter.hpp"
+
+#include <json/value.h>
+
+#include <stdexcept>
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using waybar::util::JsonFilter;
+
+TEST_CASE("Keep only the wanted members", "[util][json_filter]") {
+  const JsonFilter filter({"name", "nodes", "id"});
+
+  SECTION("at any depth, with array elements kept") {
+    auto value = filter.parse(
+        R"({"id": 1, "rect": {"x": 0, "y": 0}, "nodes": [{"id": 2, "name": "a", "type": "con"},)"
+        R"( {"id": 3, "nodes": []}], "focused": true})");
+    REQUIRE(value.getMemberNames() == std::vector<std::string>{"id", "nodes"});
+    REQUIRE(value["id"].asInt() == 1);
+    REQUIRE(value["nodes"].size() == 2);
+    REQUIRE(value["nodes"][0].getMemberNames() == std::vector<std::string>{"id", "name"});
+    REQUIRE(value["nodes"][0]["name"].asString() == "a");
+    REQUIRE(value["nodes"][1]["nodes"].isArray());
+    REQUIRE(value["nodes"][1]["nodes"].empty());
+  }
+
+  SECTION("skipping nested values, with brackets and quotes in strings") {
+    auto value = filter.parse(
+        R"({"marks": [["}", {"a": "]\""}], [], {}], "window_properties": {"title": "{[,:"},)"
+        R"( "id": 7})");
+    REQUIRE(value.getMemberNames() == std::vector<std::string>{"id"});
+    REQUIRE(value["id"].asInt() == 7);
+  }
+
+  SECTION("skipping literals and numbers followed by whitespace") {
+    auto value = filter.parse("{\"a\": true ,\"b\": null\t,\"c\": -1.5e3\r\n,\"d\": false\n}\n");
+    REQUIRE(value.isObject());
+    REQUIRE(value.empty());
+    value = filter.parse("{\"x\": 12 , \"id\": 4 }");
+    REQUIRE(value["id"].asInt() == 4);
+  }
+
+  SECTION("with literals followed by whitespace") {
+    auto value = filter.parse("[true , false\t, null\n, 1 ,2.5 ]");
+    REQUIRE(value.size() == 5);
+    REQUIRE(value[0].asBool());
+    REQUIRE(!value[1].asBool());
+    REQUIRE(value[2].isNull());
+    REQUIRE(value[3].asInt() == 1);
+    REQUIRE(value[4].asDouble() == 2.5);
+  }
+
+  SECTION("with escaped member names") {
+    const JsonFilter escaped({"na\"me"});
+    auto value = escaped.parse(R"({"na\"me": 1, "na\\me": 2})");
+    REQUIRE(value.getMemberNames() == std::vector<std::string>{"na\"me"});
+  }
+}
+
+TEST_CASE("Decode string escapes", "[util][json_filter]") {
+  const JsonFilter filter({"s"});
+  auto decode = [&filter](const std::string& json) {
+    return filter.parse("{\"s\": \"" + json + "\"}")["s"].asString();
+  };
+
+  REQUIRE(decode(R"(plain)") == "plain");
+  REQUIRE(decode(R"(a\"b\\c\/d)") == "a\"b\\c/d");
+  REQUIRE(decode(R"(\b\f\n\r\t)") == "\b\f\n\r\t");
+
+  SECTION("\\u sequences") {
+    REQUIRE(decode("\\u0041") == "A");
+    REQUIRE(decode("\\u00e9") == "\xC3\xA9");
+    REQUIRE(decode("\\u20AC") == "\xE2\x82\xAC");
+    // Surrogate pair of U+1F600
+    REQUIRE(decode("\\ud83d\\ude00") == "\xF0\x9F\x98\x80");
+    REQUIRE(decode("x\\u0041y") == "xAy");
+  }
+
+  SECTION("invalid \\u sequences") {
+    REQUIRE_THROWS_AS(decode(R"(\u00G1)"), std::runtime_error);
+    REQUIRE_THROWS_AS(decode(R"(\u12)"), std::runtime_error);
+  }
+}
+
+TEST_CASE("Reject truncated and invalid input", "[util][json_filter]") {
+  const JsonFilter filter({"id"});
+
+  for (const char* json :
+       {"", "{", "{\"id\"", "{\"id\":", "{\"id\": 1", "{\"id\": 1,", "[1, 2", "\"abc",
+        "{\"id\": \"abc\\", "{\"skip\": [1, {\"a\": 2}", "{\"skip\": \"}", "{\"id\": tru",
+        "{\"id\": 1} x", "{\"id\" 1}", "[1,]", "{,}"}) {
+    INFO(json);
+    REQUIRE_THROWS_AS(filter.parse(json), std::runtime_error);
+  }
+}
@@ -0,0 +1,57 @@
+#include "util/lru_cache.hpp"
+
+#include <string>
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/catch_test_macros.hpp>
+#else
+#include <catch2/catch.hpp>
+#endif
+
+using waybar::util::LruCache;
+
+TEST_CASE("Count cache hits and misses", "[util][lru]") {
+  LruCache<std::string, int> cache(2);
+  REQUIRE(cache.find("a") == nullptr);
+  REQUIRE(cache.put("a", 1) == 1);
+  REQUIRE(*cache.find("a") == 1);
+  REQUIRE(cache.hits() == 1);
+  REQUIRE(cache.misses() == 1);
+  REQUIRE(cache.size() == 1);
+  REQUIRE(LruCache<int, int>(0).capacity() == 1);
+}
+
+TEST_CASE("Evict the least recently used entry", "[util][lru]") {
+  LruCache<std::string, int> cache(2);
+  cache.put("a", 1);
+  cache.put("b", 2);
+
+  SECTION("in insertion order") {
+    cache.put("c", 3);
+    REQUIRE(cache.evictions() == 1);
+    REQUIRE(cache.size() == 2);
+    REQUIRE(cache.find("a") == nullptr);
+    REQUIRE(*cache.find("b") == 2);
+    REQUIRE(*cache.find("c") == 3);
+  }
+  SECTION("lookups make entries recent") {
+    cache.find("a");
+    cache.put("c", 3);
+    REQUIRE(cache.find("b") == nullptr);
+    REQUIRE(*cache.find("a") == 1);
+  }
+  SECTION("updates make entries recent without evicting") {
+    cache.put("a", 10);
+    REQUIRE(cache.evictions() == 0);
+    cache.put("c", 3);
+    REQUIRE(cache.find("b") == nullptr);
+    REQUIRE(*cache.find("a") == 10);
+  }
+  SECTION("clear") {
+    cache.clear();
+    REQUIRE(cache.size() == 0);
+    REQUIRE(cache.find("a") == nullptr);
+    cache.put("c", 3);
+    REQUIRE(cache.evictions() == 0);
+  }
+}
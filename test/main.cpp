@@ -1,4 +1,5 @@
 #define CATCH_CONFIG_RUNNER
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
 #include <glibmm.h>
 #include <spdlog/sinks/stdout_sinks.h>
 #include <spdlog/spdlog.h>
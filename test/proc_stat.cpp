@@ -0,0 +1,66 @@
+#include "util/proc_stat.hpp"
+
+#if __has_include(<catch2/catch_test_macros.hpp>)
+#include <catch2/benchmark/catch_benchmark.hpp>
+#include <catch2/catch_test_macros.hpp>
+#else
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include <catch2/catch.hpp>
+#endif
+
+#include "util/proc_file.hpp"
+
+using waybar::util::CpuTimes;
+using waybar::util::parseProcStat;
+using waybar::util::ProcFile;
+
+TEST_CASE("Parse /proc/stat", "[util][proc_stat]") {
+  CpuTimes times;
+
+  SECTION("Fixture with 8 cpus") {
+    ProcFile file("test/proc/stat");
+    parseProcStat(file.read(), times);
+    REQUIRE(times.idle.size() == 9);
+    REQUIRE(times.total.size() == 9);
+    REQUIRE(times.idle[0] == 40445871);
+    REQUIRE(times.total[0] == 338610728);
+    REQUIRE(times.idle[8] == 4870676);
+    REQUIRE(times.total[8] == 50335370);
+  }
+
+  SECTION("Storage is reused and shrinks with the cpu count") {
+    parseProcStat("cpu  1 2 3 4\ncpu0 1 2 3 4\ncpu1 0 0 0 0\nintr 5\n", times);
+    REQUIRE(times.idle.size() == 3);
+    const auto* idle = times.idle.data();
+    parseProcStat("cpu  4 3 2 1\ncpu0 4 3 2 1\n", times);
+    REQUIRE(times.idle.data() == idle);
+    REQUIRE(times.idle == std::vector<uint64_t>{1, 1});
+    REQUIRE(times.total == std::vector<uint64_t>{10, 10});
+  }
+
+  SECTION("Totals don't overflow 32 bits") {
+    parseProcStat("cpu  4294967295 4294967295 0 1\n", times);
+    REQUIRE(times.total[0] == 8589934591);
+  }
+
+  SECTION("Truncated and empty input") {
+    parseProcStat("cpu  1 2 3", times);
+    REQUIRE(times.idle == std::vector<uint64_t>{0});
+    REQUIRE(times.total == std::vector<uint64_t>{6});
+    parseProcStat("", times);
+    REQUIRE(times.idle.empty());
+  }
+}
+
+// Per-tick cost of the cpu sampler, run with `waybar_test "[benchmark]"`
+TEST_CASE("Benchmark /proc/stat reads", "[util][proc_stat][.benchmark]") {
+  ProcFile file("test/proc/stat");
+  CpuTimes times;
+
+  BENCHMARK("ProcFile read") { return file.read().size(); };
+
+  BENCHMARK("ProcFile read and parse") {
+    parseProcStat(file.read(), times);
+    return times.total[0];
+  };
+}